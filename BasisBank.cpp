@@ -0,0 +1,320 @@
+/*-----------------------------------------------------------------------------*\
+| Low rank approximation of large, highly correlated IR banks (e.g. HRIR sets). |
+| Every IR is represented by the mean IR plus a weighted sum of numBasis        |
+| principal components, so only numBasis+1 sets of filter spectra and           |
+| numIR*numBasis weights are stored. The components are the leading right       |
+| singular vectors of the mean free IR matrix, found by a randomized range      |
+| finder with a few power iterations (only products with the IR matrix are      |
+| needed, never its covariance), followed by an exact eigen decomposition of    |
+| the small projected problem (Jacobi). Since the FFT is linear, the spectra of |
+| an IR are the same weighted sum of the component spectra, so TVOLAP can       |
+| reconstruct them on demand into its IR cache. The reconstruction error is     |
+| measured against the original IRs.                                            |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include "BasisBank.h"
+
+#define BASIS_OVERSAMPLING 10
+#define BASIS_NUM_POWER_ITERATIONS 4
+#define JACOBI_MAX_SWEEPS 64
+
+struct ValueGreater
+{
+    const double *values;
+
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+        return values[a] > values[b];
+    }
+};
+
+BasisBank::BasisBank(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+        uint32_t blockLen, uint32_t numBasis, uint32_t numBuildThreads)
+{
+    uint32_t dimIR = numChansIR*lenIR, numVecs, irCnt, vecCnt, vecCnt2, basisCnt, sampleCnt, iterCnt, passCnt, seed = 1;
+    double sum, norm, energy, residual, sumEnergy = 0.0, sumResidual = 0.0, maxError = 0.0;
+    std::vector<double> mean(dimIR, 0.0), rangeVecs, projected, gram, eigenVectors, eigenValues, basisIR, tmpIR(dimIR);
+    std::vector<uint32_t> order;
+    ValueGreater greater;
+
+    if (interleavedIR == NULL)
+        throw std::runtime_error("Impulse response is missing.");
+
+    if (numIR < 2 || dimIR == 0 || numBasis == 0 || numBasis >= numIR || numBasis > dimIR)
+        throw std::runtime_error("Number of basis IRs must be at least 1 and less than the number of IRs.");
+
+    this->numIR = numIR;
+    this->numBasis = numBasis;
+    numVecs = std::min(numBasis+BASIS_OVERSAMPLING, std::min(numIR, dimIR));
+
+    for (irCnt=0; irCnt<numIR; irCnt++)
+    {
+        for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+            mean[sampleCnt] += interleavedIR[uint64_t(irCnt)*dimIR+sampleCnt];
+    }
+    for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+        mean[sampleCnt] /= numIR;
+
+    // deterministic start vectors, so the bank does not change from run to run
+    rangeVecs.resize(uint64_t(numVecs)*dimIR);
+    for (sampleCnt=0; sampleCnt<rangeVecs.size(); sampleCnt++)
+    {
+        seed = seed*1664525u+1013904223u;
+        rangeVecs[sampleCnt] = double(seed)/4294967296.0-0.5;
+    }
+
+    // range finder: rangeVecs = orth((A^T A)^k * random), A being the mean free IR matrix (numIR x dimIR)
+    projected.resize(uint64_t(numIR)*numVecs);
+    for (iterCnt=0; iterCnt<=BASIS_NUM_POWER_ITERATIONS; iterCnt++)
+    {
+        if (iterCnt > 0)
+        {
+            for (vecCnt=0; vecCnt<numVecs; vecCnt++)
+            {
+                double *vec = &rangeVecs[uint64_t(vecCnt)*dimIR];
+
+                std::fill(vec, vec+dimIR, 0.0);
+                for (irCnt=0; irCnt<numIR; irCnt++)
+                {
+                    const double *ir = &interleavedIR[uint64_t(irCnt)*dimIR];
+                    for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                        vec[sampleCnt] += (ir[sampleCnt]-mean[sampleCnt])*projected[uint64_t(irCnt)*numVecs+vecCnt];
+                }
+            }
+        }
+
+        // modified Gram-Schmidt, twice for orthogonality, linearly dependent vectors become zero
+        for (vecCnt=0; vecCnt<numVecs; vecCnt++)
+        {
+            double *vec = &rangeVecs[uint64_t(vecCnt)*dimIR];
+
+            for (passCnt=0; passCnt<2; passCnt++)
+            {
+                for (vecCnt2=0; vecCnt2<vecCnt; vecCnt2++)
+                {
+                    const double *prev = &rangeVecs[uint64_t(vecCnt2)*dimIR];
+                    for (sum=0.0, sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                        sum += vec[sampleCnt]*prev[sampleCnt];
+                    for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                        vec[sampleCnt] -= sum*prev[sampleCnt];
+                }
+            }
+
+            for (norm=0.0, sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                norm += vec[sampleCnt]*vec[sampleCnt];
+            norm = norm > 0.0 ? 1.0/sqrt(norm) : 0.0;
+            for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                vec[sampleCnt] *= norm;
+        }
+
+        // projected = A * rangeVecs
+        for (irCnt=0; irCnt<numIR; irCnt++)
+        {
+            const double *ir = &interleavedIR[uint64_t(irCnt)*dimIR];
+            for (vecCnt=0; vecCnt<numVecs; vecCnt++)
+            {
+                const double *vec = &rangeVecs[uint64_t(vecCnt)*dimIR];
+                for (sum=0.0, sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                    sum += (ir[sampleCnt]-mean[sampleCnt])*vec[sampleCnt];
+                projected[uint64_t(irCnt)*numVecs+vecCnt] = sum;
+            }
+        }
+    }
+
+    // principal components within the range: eigen vectors of projected^T * projected
+    gram.resize(numVecs*numVecs);
+    for (vecCnt=0; vecCnt<numVecs; vecCnt++)
+    {
+        for (vecCnt2=0; vecCnt2<numVecs; vecCnt2++)
+        {
+            for (sum=0.0, irCnt=0; irCnt<numIR; irCnt++)
+                sum += projected[uint64_t(irCnt)*numVecs+vecCnt]*projected[uint64_t(irCnt)*numVecs+vecCnt2];
+            gram[vecCnt*numVecs+vecCnt2] = sum;
+        }
+    }
+
+    eigenSymmetric(gram, numVecs, eigenVectors, eigenValues);
+
+    order.resize(numVecs);
+    for (vecCnt=0; vecCnt<numVecs; vecCnt++)
+        order[vecCnt] = vecCnt;
+    greater.values = eigenValues.data();
+    std::sort(order.begin(), order.end(), greater);
+
+    // IR 0 of the basis is the mean, IR n the component n-1
+    basisIR.resize(uint64_t(numBasis+1)*dimIR, 0.0);
+    std::copy(mean.begin(), mean.end(), basisIR.begin());
+    weights.resize(uint64_t(numIR)*numBasis);
+    for (basisCnt=0; basisCnt<numBasis; basisCnt++)
+    {
+        double *vec = &basisIR[uint64_t(basisCnt+1)*dimIR];
+
+        for (vecCnt=0; vecCnt<numVecs; vecCnt++)
+        {
+            const double *range = &rangeVecs[uint64_t(vecCnt)*dimIR];
+            for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                vec[sampleCnt] += eigenVectors[vecCnt*numVecs+order[basisCnt]]*range[sampleCnt];
+        }
+
+        for (irCnt=0; irCnt<numIR; irCnt++)
+        {
+            for (sum=0.0, vecCnt=0; vecCnt<numVecs; vecCnt++)
+                sum += projected[uint64_t(irCnt)*numVecs+vecCnt]*eigenVectors[vecCnt*numVecs+order[basisCnt]];
+            weights[uint64_t(irCnt)*numBasis+basisCnt] = sum;
+        }
+    }
+
+    for (irCnt=0; irCnt<numIR; irCnt++)
+    {
+        const double *ir = &interleavedIR[uint64_t(irCnt)*dimIR];
+
+        std::copy(mean.begin(), mean.end(), tmpIR.begin());
+        for (basisCnt=0; basisCnt<numBasis; basisCnt++)
+        {
+            for (sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+                tmpIR[sampleCnt] += weights[uint64_t(irCnt)*numBasis+basisCnt]*basisIR[uint64_t(basisCnt+1)*dimIR+sampleCnt];
+        }
+
+        for (energy=residual=0.0, sampleCnt=0; sampleCnt<dimIR; sampleCnt++)
+        {
+            energy += ir[sampleCnt]*ir[sampleCnt];
+            residual += (ir[sampleCnt]-tmpIR[sampleCnt])*(ir[sampleCnt]-tmpIR[sampleCnt]);
+        }
+
+        sumEnergy += energy;
+        sumResidual += residual;
+        if (energy > 0.0)
+            maxError = std::max(maxError, residual/energy);
+    }
+
+    errorDB = 10.0*log10(std::max(sumEnergy > 0.0 ? sumResidual/sumEnergy : 0.0, 1e-300));
+    maxErrorDB = 10.0*log10(std::max(maxError, 1e-300));
+
+    basis.reset(new FilterBank(basisIR.data(), numBasis+1, lenIR, numChansIR, blockLen, numBuildThreads));
+    numBins = 2*blockLen+1;
+    numPartsIR = basis->getNumParts()/(numBasis+1);
+}
+
+void BasisBank::reconstruct(uint32_t irIdx, complex_float64 *bins) const
+{
+    uint32_t partCnt, basisCnt, binCnt;
+    const double *irWeights = getWeights(irIdx);
+    const complex_float64 *src;
+    complex_float64 *dest;
+    double weight;
+
+    for (partCnt=0; partCnt<numPartsIR; partCnt++)
+    {
+        dest = bins+uint64_t(partCnt)*numBins;
+        src = basis->getParts(0)[partCnt];
+        for (binCnt=0; binCnt<numBins; binCnt++)
+            dest[binCnt] = src[binCnt];
+
+        for (basisCnt=0; basisCnt<numBasis; basisCnt++)
+        {
+            weight = irWeights[basisCnt];
+            src = basis->getParts(basisCnt+1)[partCnt];
+            for (binCnt=0; binCnt<numBins; binCnt++)
+            {
+                dest[binCnt].re += weight*src[binCnt].re;
+                dest[binCnt].im += weight*src[binCnt].im;
+            }
+        }
+    }
+}
+
+uint64_t BasisBank::getNumBytes() const
+{
+    return basis->getNumBytes()+weights.capacity()*sizeof(double);
+}
+
+// cyclic Jacobi rotations, the columns of eigenVectors are the eigen vectors
+void BasisBank::eigenSymmetric(std::vector<double> &matrix, uint32_t size, std::vector<double> &eigenVectors,
+        std::vector<double> &eigenValues)
+{
+    uint32_t rowCnt, colCnt, idxCnt, sweepCnt;
+    double offDiag, diag, theta, tanPhi, cosPhi, sinPhi, valP, valQ;
+
+    eigenVectors.assign(size*size, 0.0);
+    for (rowCnt=0; rowCnt<size; rowCnt++)
+        eigenVectors[rowCnt*size+rowCnt] = 1.0;
+
+    for (sweepCnt=0; sweepCnt<JACOBI_MAX_SWEEPS; sweepCnt++)
+    {
+        for (offDiag=diag=0.0, rowCnt=0; rowCnt<size; rowCnt++)
+        {
+            diag += matrix[rowCnt*size+rowCnt]*matrix[rowCnt*size+rowCnt];
+            for (colCnt=rowCnt+1; colCnt<size; colCnt++)
+                offDiag += matrix[rowCnt*size+colCnt]*matrix[rowCnt*size+colCnt];
+        }
+
+        if (offDiag <= 1e-30*diag)
+            break;
+
+        for (rowCnt=0; rowCnt+1<size; rowCnt++)
+        {
+            for (colCnt=rowCnt+1; colCnt<size; colCnt++)
+            {
+                if (matrix[rowCnt*size+colCnt] == 0.0)
+                    continue;
+
+                // rotation in the plane (rowCnt, colCnt) that zeroes the element
+                theta = (matrix[colCnt*size+colCnt]-matrix[rowCnt*size+rowCnt])/(2.0*matrix[rowCnt*size+colCnt]);
+                tanPhi = (theta >= 0.0 ? 1.0 : -1.0)/(fabs(theta)+sqrt(theta*theta+1.0));
+                cosPhi = 1.0/sqrt(tanPhi*tanPhi+1.0);
+                sinPhi = tanPhi*cosPhi;
+
+                for (idxCnt=0; idxCnt<size; idxCnt++)
+                {
+                    valP = matrix[idxCnt*size+rowCnt];
+                    valQ = matrix[idxCnt*size+colCnt];
+                    matrix[idxCnt*size+rowCnt] = cosPhi*valP-sinPhi*valQ;
+                    matrix[idxCnt*size+colCnt] = sinPhi*valP+cosPhi*valQ;
+                }
+
+                for (idxCnt=0; idxCnt<size; idxCnt++)
+                {
+                    valP = matrix[rowCnt*size+idxCnt];
+                    valQ = matrix[colCnt*size+idxCnt];
+                    matrix[rowCnt*size+idxCnt] = cosPhi*valP-sinPhi*valQ;
+                    matrix[colCnt*size+idxCnt] = sinPhi*valP+cosPhi*valQ;
+                }
+
+                for (idxCnt=0; idxCnt<size; idxCnt++)
+                {
+                    valP = eigenVectors[idxCnt*size+rowCnt];
+                    valQ = eigenVectors[idxCnt*size+colCnt];
+                    eigenVectors[idxCnt*size+rowCnt] = cosPhi*valP-sinPhi*valQ;
+                    eigenVectors[idxCnt*size+colCnt] = sinPhi*valP+cosPhi*valQ;
+                }
+            }
+        }
+    }
+
+    eigenValues.resize(size);
+    for (rowCnt=0; rowCnt<size; rowCnt++)
+        eigenValues[rowCnt] = matrix[rowCnt*size+rowCnt];
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,103 @@
+/*-----------------------------------------------------------------------------*\
+| Header of BasisBank.cpp, for explanation see cpp-file.                        |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef BASISBANK_H
+#define BASISBANK_H
+
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include "fft.h"
+#include "FilterBank.h"
+
+class BasisBank
+{
+
+public:
+    // interleavedIR in the layout of FilterBank, approximated by the mean IR and numBasis principal
+    // components, whose spectra are transformed on numBuildThreads threads (0 = all cores)
+    BasisBank(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+            uint32_t blockLen, uint32_t numBasis, uint32_t numBuildThreads = 1);
+
+    // spectra of IR irIdx, numChansIR*numParts partitions of 2*blockLen+1 bins one after another
+    void reconstruct(uint32_t irIdx, complex_float64 *bins) const;
+
+    // numBasis weights of IR irIdx
+    inline const double *getWeights(uint32_t irIdx) const
+    {
+        return &weights[uint64_t(irIdx)*numBasis];
+    }
+
+    inline uint32_t getBlockLen() const
+    {
+        return basis->getBlockLen();
+    }
+
+    inline uint32_t getNumIR() const
+    {
+        return numIR;
+    }
+
+    inline uint32_t getNumChansIR() const
+    {
+        return basis->getNumChansIR();
+    }
+
+    inline uint32_t getLenIR() const
+    {
+        return basis->getLenIR();
+    }
+
+    inline uint32_t getNumBasis() const
+    {
+        return numBasis;
+    }
+
+    // energy of the approximation error relative to the IR energy in dB, of the whole bank and of the worst IR
+    inline double getErrorDB() const
+    {
+        return errorDB;
+    }
+
+    inline double getMaxErrorDB() const
+    {
+        return maxErrorDB;
+    }
+
+    uint64_t getNumBytes() const;
+
+private:
+    BasisBank(const BasisBank &);
+    BasisBank &operator=(const BasisBank &);
+
+    static void eigenSymmetric(std::vector<double> &matrix, uint32_t size, std::vector<double> &eigenVectors,
+            std::vector<double> &eigenValues);
+
+    uint32_t numIR, numBasis, numBins, numPartsIR;
+    double errorDB, maxErrorDB;
+    std::unique_ptr<FilterBank> basis;
+    std::vector<double> weights;
+};
+
+#endif // BASISBANK_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,171 @@
+/*-----------------------------------------------------------------------------*\
+| Nearest neighbour lookup of IR positions for head tracking. The positions are |
+| converted to cartesian points (on the unit sphere if no distances are given,  |
+| so the azimuth wraps around correctly and the poles are no special case) and  |
+| stored as an implicit, balanced k-d tree: every index range is split at its   |
+| median along x, y and z in turn. A lookup descends to the leaf of the query   |
+| and only visits the other halves whose splitting plane is nearer than the     |
+| best match so far, which takes O(log n) steps for evenly spread HRIR grids.   |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <cmath>
+#include <algorithm>
+#include "DirectionIndex.h"
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+#define DIRECTION_NUM_AXES 3
+
+struct PointAxisLess
+{
+    const double *points;
+    uint32_t axis;
+
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+        return points[a*DIRECTION_NUM_AXES+axis] < points[b*DIRECTION_NUM_AXES+axis];
+    }
+};
+
+DirectionIndex::DirectionIndex()
+{
+    hasDistance = false;
+}
+
+int DirectionIndex::build(const std::vector<double> &azimuth, const std::vector<double> &elevation,
+        const std::vector<double> &distance)
+{
+    uint32_t posCnt, numPositions = uint32_t(azimuth.size());
+
+    if (numPositions == 0 || elevation.size() != numPositions || (!distance.empty() && distance.size() != numPositions))
+        return -1;
+
+    for (posCnt=0; posCnt<distance.size(); posCnt++)
+    {
+        if (!(distance[posCnt] > 0.0))
+            return -1;
+    }
+
+    hasDistance = !distance.empty();
+    points.resize(numPositions*DIRECTION_NUM_AXES);
+    tree.resize(numPositions);
+    for (posCnt=0; posCnt<numPositions; posCnt++)
+    {
+        toCartesian(azimuth[posCnt], elevation[posCnt], hasDistance ? distance[posCnt] : 1.0, &points[posCnt*DIRECTION_NUM_AXES]);
+        tree[posCnt] = posCnt;
+    }
+
+    buildTree(0, numPositions, 0);
+
+    return 0;
+}
+
+uint32_t DirectionIndex::findNearest(double azimuth, double elevation, double distance, uint32_t prevIdx,
+        double hysteresis) const
+{
+    double point[DIRECTION_NUM_AXES], bestDistSq = HUGE_VAL;
+    uint32_t bestIdx = 0;
+
+    toCartesian(azimuth, elevation, (hasDistance && distance > 0.0) ? distance : 1.0, point);
+    searchTree(0, uint32_t(tree.size()), 0, point, bestIdx, bestDistSq);
+
+    if (prevIdx < tree.size() && prevIdx != bestIdx && sqrt(getDistSq(prevIdx, point)) <= sqrt(bestDistSq)+hysteresis)
+        return prevIdx;
+
+    return bestIdx;
+}
+
+void DirectionIndex::getPosition(uint32_t posIdx, double &azimuth, double &elevation, double &distance) const
+{
+    const double *pos = &points.at(posIdx*DIRECTION_NUM_AXES);
+
+    distance = sqrt(pos[0]*pos[0]+pos[1]*pos[1]+pos[2]*pos[2]);
+    azimuth = atan2(pos[1], pos[0])*180.0/M_PI;
+    elevation = asin(std::max(-1.0, std::min(pos[2]/distance, 1.0)))*180.0/M_PI;
+}
+
+void DirectionIndex::toCartesian(double azimuth, double elevation, double distance, double *point) const
+{
+    double az = azimuth*M_PI/180.0, el = elevation*M_PI/180.0;
+
+    point[0] = distance*cos(el)*cos(az);
+    point[1] = distance*cos(el)*sin(az);
+    point[2] = distance*sin(el);
+}
+
+double DirectionIndex::getDistSq(uint32_t posIdx, const double *point) const
+{
+    const double *pos = &points[posIdx*DIRECTION_NUM_AXES];
+
+    return (pos[0]-point[0])*(pos[0]-point[0])+(pos[1]-point[1])*(pos[1]-point[1])+(pos[2]-point[2])*(pos[2]-point[2]);
+}
+
+void DirectionIndex::buildTree(uint32_t beg, uint32_t end, uint32_t axis)
+{
+    uint32_t mid = beg+(end-beg)/2;
+    PointAxisLess less;
+
+    if (end-beg < 2)
+        return;
+
+    less.points = points.data();
+    less.axis = axis;
+    std::nth_element(tree.begin()+beg, tree.begin()+mid, tree.begin()+end, less);
+
+    buildTree(beg, mid, (axis+1)%DIRECTION_NUM_AXES);
+    buildTree(mid+1, end, (axis+1)%DIRECTION_NUM_AXES);
+}
+
+void DirectionIndex::searchTree(uint32_t beg, uint32_t end, uint32_t axis, const double *point, uint32_t &bestIdx,
+        double &bestDistSq) const
+{
+    uint32_t mid = beg+(end-beg)/2, nextAxis = (axis+1)%DIRECTION_NUM_AXES;
+    double distSq, planeDist;
+
+    if (beg >= end)
+        return;
+
+    distSq = getDistSq(tree[mid], point);
+    if (distSq < bestDistSq || (distSq == bestDistSq && tree[mid] < bestIdx))
+    {
+        bestDistSq = distSq;
+        bestIdx = tree[mid];
+    }
+
+    // the half of the query first, the other one only if its splitting plane is not too far
+    planeDist = point[axis]-points[tree[mid]*DIRECTION_NUM_AXES+axis];
+    if (planeDist < 0.0)
+    {
+        searchTree(beg, mid, nextAxis, point, bestIdx, bestDistSq);
+        if (planeDist*planeDist <= bestDistSq)
+            searchTree(mid+1, end, nextAxis, point, bestIdx, bestDistSq);
+    }
+    else
+    {
+        searchTree(mid+1, end, nextAxis, point, bestIdx, bestDistSq);
+        if (planeDist*planeDist <= bestDistSq)
+            searchTree(beg, mid, nextAxis, point, bestIdx, bestDistSq);
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
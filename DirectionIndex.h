@@ -0,0 +1,67 @@
+/*-----------------------------------------------------------------------------*\
+| Header of DirectionIndex.cpp, for explanation see cpp-file.                   |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef DIRECTIONINDEX_H
+#define DIRECTIONINDEX_H
+
+#include <stdint.h>
+#include <vector>
+
+class DirectionIndex
+{
+
+public:
+    DirectionIndex();
+
+    // angles in degrees (azimuth counterclockwise from the front, elevation upwards), distance is
+    // empty (all positions on the unit sphere) or holds one value > 0 per position
+    int build(const std::vector<double> &azimuth, const std::vector<double> &elevation,
+            const std::vector<double> &distance);
+
+    // index of the position nearest to the direction (distance <= 0 or ignored without distances).
+    // prevIdx (if < getNumPositions()) is kept unless another position is closer by more than hysteresis.
+    uint32_t findNearest(double azimuth, double elevation, double distance, uint32_t prevIdx,
+            double hysteresis) const;
+
+    // distance is 1 for positions on the unit sphere
+    void getPosition(uint32_t posIdx, double &azimuth, double &elevation, double &distance) const;
+
+    inline uint32_t getNumPositions() const
+    {
+        return uint32_t(tree.size());
+    }
+
+private:
+    void toCartesian(double azimuth, double elevation, double distance, double *point) const;
+    double getDistSq(uint32_t posIdx, const double *point) const;
+    void buildTree(uint32_t beg, uint32_t end, uint32_t axis);
+    void searchTree(uint32_t beg, uint32_t end, uint32_t axis, const double *point, uint32_t &bestIdx,
+            double &bestDistSq) const;
+
+    bool hasDistance;
+    std::vector<double> points;
+    std::vector<uint32_t> tree;
+};
+
+#endif // DIRECTIONINDEX_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,368 @@
+/*-----------------------------------------------------------------------------*\
+| Immutable bank of partitioned filter spectra. It is built once, from memory,  |
+| a provider callback or a precomputed spectra file, and shared by reference    |
+| counting between any number of TVOLAP instances, which then only hold their   |
+| own delay lines, overlap memories and IR selection. Nothing is modified after |
+| construction, so instances on different threads read it without              |
+| synchronization. Since the MAC is bound by memory bandwidth, a bank can be    |
+| converted to spectra in float32, bfloat16 or int16 block floating point.      |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "FilterBank.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+// size of the blocks the unique spectra are appended to, they never move once written
+#define FILTERBANK_CHUNK_BYTES (1 << 18)
+
+struct FilterBank::Build
+{
+    FilterBank *bank;
+    IRProvider provider;
+    void *context;
+    const double *interleavedIR;
+    uint32_t lenIR, firstTask;
+    std::vector< std::vector<double> > tmpPartIR;
+    std::vector< std::vector<complex_float64> > tmpSpectrum;
+    std::unordered_multimap<uint64_t, const complex_float64 *> uniqueParts;
+    std::mutex mergeMutex;
+    std::atomic<bool> failed;
+
+    static void job(void *context, uint32_t taskIdx, uint32_t threadIdx);
+    void merge(uint32_t partIdx, const complex_float64 *spectrum);
+};
+
+void FilterBank::Build::job(void *context, uint32_t taskIdx, uint32_t threadIdx)
+{
+    Build &build = *(Build *) context;
+    FilterBank &bank = *build.bank;
+    uint32_t partIdx = build.firstTask+taskIdx;
+    uint32_t partCnt = partIdx%bank.numParts, chanCnt = (partIdx/bank.numParts)%bank.numChansIR, irCnt = partIdx/(bank.numParts*bank.numChansIR);
+    uint32_t partBeg = std::min(partCnt*bank.processLen, build.lenIR), partLen = std::min(bank.processLen, build.lenIR-partBeg);
+    uint32_t sampleCnt;
+    std::vector<double> &tmpPartIR = build.tmpPartIR[threadIdx];
+    complex_float64 *spectrum = build.tmpSpectrum[threadIdx].data();
+
+    // the samples of one partition are read directly from the source, without a padded copy of the bank
+    if (build.provider == NULL)
+        transformPartition(build.interleavedIR+(uint64_t(irCnt)*bank.numChansIR+chanCnt)*build.lenIR+partBeg, partLen, spectrum, tmpPartIR);
+    else
+    {
+        if (build.provider(build.context, irCnt, chanCnt, partBeg, partLen, tmpPartIR.data()) < 0)
+            build.failed.store(true, std::memory_order_relaxed);
+
+        for (sampleCnt=partLen; sampleCnt<bank.nfft; sampleCnt++)
+            tmpPartIR[sampleCnt] = 0.0;
+
+        rfft_double(tmpPartIR.data(), spectrum, bank.nfft);
+    }
+
+    build.merge(partIdx, spectrum);
+}
+
+void FilterBank::Build::merge(uint32_t partIdx, const complex_float64 *spectrum)
+{
+    std::unordered_multimap<uint64_t, const complex_float64 *>::const_iterator partIt;
+    uint64_t hash;
+    uint32_t byteCnt, numBytes = (bank->processLen+1)*sizeof(complex_float64);
+    const unsigned char *spectrumBytes = (const unsigned char *) spectrum;
+    complex_float64 *uniqueSpectrum;
+
+    // FNV-1a over the bit pattern outside the lock, equal hashes are compared completely
+    hash = 14695981039346656037ull;
+    for (byteCnt=0; byteCnt<numBytes; byteCnt++)
+        hash = (hash^spectrumBytes[byteCnt])*1099511628211ull;
+
+    std::lock_guard<std::mutex> guard(mergeMutex);
+
+    std::pair<std::unordered_multimap<uint64_t, const complex_float64 *>::const_iterator,
+            std::unordered_multimap<uint64_t, const complex_float64 *>::const_iterator> range = uniqueParts.equal_range(hash);
+    for (partIt=range.first; partIt!=range.second; partIt++)
+    {
+        if (memcmp(partIt->second, spectrum, numBytes) == 0)
+        {
+            bank->parts[partIdx] = partIt->second;
+            return;
+        }
+    }
+
+    // only spectra not seen before are stored, so the bank never holds more than its unique size
+    uniqueSpectrum = bank->appendPart();
+    memcpy(uniqueSpectrum, spectrum, numBytes);
+    uniqueParts.insert(std::make_pair(hash, (const complex_float64 *) uniqueSpectrum));
+    bank->parts[partIdx] = uniqueSpectrum;
+}
+
+FilterBank::FilterBank(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+        uint32_t blockLen, uint32_t numBuildThreads)
+{
+    if (interleavedIR == NULL)
+        throw std::runtime_error("Impulse response is missing.");
+
+    init(numIR, lenIR, numChansIR, blockLen);
+    build(NULL, NULL, interleavedIR, lenIR, numBuildThreads);
+}
+
+FilterBank::FilterBank(IRProvider provider, void *context, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+        uint32_t blockLen, uint32_t numBuildThreads)
+{
+    if (provider == NULL)
+        throw std::runtime_error("Impulse response provider is missing.");
+
+    init(numIR, lenIR, numChansIR, blockLen);
+    build(provider, context, NULL, lenIR, numBuildThreads);
+}
+
+FilterBank::~FilterBank()
+{
+}
+
+void FilterBank::init(uint32_t numIR, uint32_t lenIR, uint32_t numChansIR, uint32_t blockLen)
+{
+    if (numIR == 0 || lenIR == 0 || numChansIR == 0 || blockLen == 0)
+        throw std::runtime_error("Number of IRs, IR length, number of IR channels and block length must be positive.");
+
+    this->blockLen = blockLen;
+    this->processLen = 2*blockLen;
+    this->nfft = 2*processLen;
+    this->numIR = numIR;
+    this->numChansIR = numChansIR;
+    this->numParts = (lenIR-1)/processLen+1;
+    this->numUniqueParts = 0;
+    this->partsPerChunk = std::max(uint32_t(FILTERBANK_CHUNK_BYTES/((processLen+1)*sizeof(complex_float64))), 1u);
+    this->precision = PRECISION_FLOAT64;
+    this->snrDB = std::numeric_limits<double>::infinity();
+}
+
+void FilterBank::build(IRProvider provider, void *context, const double *interleavedIR, uint32_t lenIR, uint32_t numBuildThreads)
+{
+    Build build;
+    uint32_t threadCnt, taskCnt, numTasks = numIR*numChansIR*numParts;
+
+    if (numBuildThreads == 0)
+        numBuildThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    numBuildThreads = std::min(numBuildThreads, numTasks);
+
+    build.bank = this;
+    build.provider = provider;
+    build.context = context;
+    build.interleavedIR = interleavedIR;
+    build.lenIR = lenIR;
+    build.firstTask = 0;
+    build.failed.store(false);
+    build.tmpPartIR.resize(numBuildThreads);
+    build.tmpSpectrum.resize(numBuildThreads);
+    for (threadCnt=0; threadCnt<numBuildThreads; threadCnt++)
+    {
+        build.tmpPartIR.at(threadCnt).resize(nfft);
+        build.tmpSpectrum.at(threadCnt).resize(processLen+1);
+    }
+
+    // every partition is transformed into the scratch of its thread and merged right away
+    parts.resize(numTasks);
+
+    // the first transform initializes the twiddle table of fft.cpp before other threads use it
+    Build::job(&build, 0, 0);
+    build.firstTask = 1;
+
+    if (numBuildThreads < 2)
+    {
+        for (taskCnt=0; taskCnt<numTasks-1; taskCnt++)
+            Build::job(&build, taskCnt, 0);
+    }
+    else
+    {
+        ThreadPool pool(numBuildThreads);
+        pool.run(&Build::job, &build, numTasks-1);
+    }
+
+    if (build.failed.load())
+        throw std::runtime_error("Impulse response provider failed.");
+}
+
+complex_float64 *FilterBank::appendPart()
+{
+    uint32_t chunkPos = numUniqueParts%partsPerChunk;
+
+    if (chunkPos == 0)
+        binChunks.push_back(std::vector<complex_float64>(uint64_t(partsPerChunk)*(processLen+1)));
+
+    numUniqueParts++;
+
+    return &binChunks.back()[uint64_t(chunkPos)*(processLen+1)];
+}
+
+FilterBank::FilterBank(const FilterBank &source, Precision precision)
+{
+    std::unordered_map<const complex_float64 *, uint32_t> uniqueIdx;
+    std::vector<const complex_float64 *> uniqueParts, copiedParts;
+    uint32_t partCnt, sampleCnt, numBins, partWords;
+    double energy, sumEnergy = 0.0, sumError = 0.0;
+
+    if (source.precision != PRECISION_FLOAT64)
+        throw std::runtime_error("Source filter bank must be stored in double precision.");
+
+    init(source.numIR, source.numParts*source.processLen, source.numChansIR, source.blockLen);
+    this->precision = precision;
+    numBins = processLen+1;
+
+    // the shared partitions of the source (also of a mapped spectra file) are converted once
+    for (partCnt=0; partCnt<source.parts.size(); partCnt++)
+    {
+        if (uniqueIdx.find(source.parts[partCnt]) == uniqueIdx.end())
+        {
+            uniqueIdx[source.parts[partCnt]] = uint32_t(uniqueParts.size());
+            uniqueParts.push_back(source.parts[partCnt]);
+        }
+    }
+    numUniqueParts = uint32_t(uniqueParts.size());
+
+    if (precision == PRECISION_FLOAT64)
+    {
+        numUniqueParts = 0;
+        copiedParts.resize(uniqueParts.size());
+        for (partCnt=0; partCnt<uniqueParts.size(); partCnt++)
+        {
+            complex_float64 *spectrum = appendPart();
+            std::copy(uniqueParts[partCnt], uniqueParts[partCnt]+numBins, spectrum);
+            copiedParts[partCnt] = spectrum;
+        }
+
+        parts.resize(source.parts.size());
+        for (partCnt=0; partCnt<parts.size(); partCnt++)
+            parts[partCnt] = copiedParts[uniqueIdx[source.parts[partCnt]]];
+
+        return;
+    }
+
+    if (precision == PRECISION_FLOAT32)
+        partWords = (numBins*sizeof(complex_float32)+sizeof(uint64_t)-1)/sizeof(uint64_t);
+    else if (precision == PRECISION_BFLOAT16)
+        partWords = (numBins*2*sizeof(uint16_t)+sizeof(uint64_t)-1)/sizeof(uint64_t);
+    else if (precision == PRECISION_INT16)
+        partWords = 1+(numBins*2*sizeof(int16_t)+sizeof(uint64_t)-1)/sizeof(uint64_t);
+    else
+        throw std::runtime_error("Precision is not supported.");
+
+    reducedData.resize(uint64_t(numUniqueParts)*partWords);
+    for (partCnt=0; partCnt<numUniqueParts; partCnt++)
+    {
+        for (energy=0.0, sampleCnt=0; sampleCnt<numBins; sampleCnt++)
+            energy += uniqueParts[partCnt][sampleCnt].re*uniqueParts[partCnt][sampleCnt].re+uniqueParts[partCnt][sampleCnt].im*uniqueParts[partCnt][sampleCnt].im;
+
+        sumEnergy += energy;
+        sumError += reducePartition(uniqueParts[partCnt], numBins, precision, &reducedData[uint64_t(partCnt)*partWords]);
+    }
+
+    reducedParts.resize(source.parts.size());
+    for (partCnt=0; partCnt<reducedParts.size(); partCnt++)
+        reducedParts[partCnt] = &reducedData[uint64_t(uniqueIdx[source.parts[partCnt]])*partWords];
+
+    snrDB = sumError > 0.0 ? 10.0*log10(sumEnergy/sumError) : std::numeric_limits<double>::infinity();
+}
+
+double FilterBank::reducePartition(const complex_float64 *spectrum, uint32_t numBins, Precision precision, void *dest)
+{
+    uint32_t sampleCnt, valueCnt, bits;
+    int blockExp;
+    double value, rounded, maxValue = 0.0, scale, error = 0.0;
+    float single;
+
+    if (precision == PRECISION_INT16)
+    {
+        // block floating point like TVOLAP32::normalize(), one power of two scale per partition
+        for (sampleCnt=0; sampleCnt<numBins; sampleCnt++)
+            maxValue = std::max(maxValue, std::max(fabs(spectrum[sampleCnt].re), fabs(spectrum[sampleCnt].im)));
+
+        frexp(maxValue, &blockExp);
+        scale = ldexp(1.0, blockExp-15);
+        memcpy(dest, &scale, sizeof(scale));
+    }
+    else
+        scale = 1.0;
+
+    for (valueCnt=0; valueCnt<2*numBins; valueCnt++)
+    {
+        value = valueCnt%2 == 0 ? spectrum[valueCnt/2].re : spectrum[valueCnt/2].im;
+        single = float(value);
+
+        if (precision == PRECISION_FLOAT32)
+        {
+            ((float *) dest)[valueCnt] = single;
+            rounded = single;
+        }
+        else if (precision == PRECISION_BFLOAT16)
+        {
+            // round to nearest even on the upper 16 bits
+            memcpy(&bits, &single, sizeof(bits));
+            bits = (bits+0x7FFFu+((bits >> 16) & 1u)) & 0xFFFF0000u;
+            ((uint16_t *) dest)[valueCnt] = uint16_t(bits >> 16);
+            memcpy(&single, &bits, sizeof(bits));
+            rounded = single;
+        }
+        else
+        {
+            rounded = std::max(-32767.0, std::min(floor(value/scale+0.5), 32767.0));
+            ((int16_t *) ((double *) dest+1))[valueCnt] = int16_t(rounded);
+            rounded *= scale;
+        }
+
+        error += (value-rounded)*(value-rounded);
+    }
+
+    return error;
+}
+
+uint64_t FilterBank::getNumBytes() const
+{
+    uint64_t numBytes = 0;
+    uint32_t chunkCnt;
+
+    for (chunkCnt=0; chunkCnt<binChunks.size(); chunkCnt++)
+        numBytes += binChunks[chunkCnt].capacity()*sizeof(complex_float64);
+
+    return numBytes+parts.capacity()*sizeof(const complex_float64 *)+
+            reducedData.capacity()*sizeof(uint64_t)+reducedParts.capacity()*sizeof(const void *);
+}
+
+void FilterBank::transformPartition(const double *partIR, uint32_t partLen, complex_float64 *spectrum,
+        std::vector<double> &tmpPartIR)
+{
+    uint32_t sampleCnt, nfft = uint32_t(tmpPartIR.size());
+
+    for (sampleCnt=0; sampleCnt<partLen; sampleCnt++)
+        tmpPartIR[sampleCnt] = partIR[sampleCnt];
+    for (sampleCnt=partLen; sampleCnt<nfft; sampleCnt++)
+        tmpPartIR[sampleCnt] = 0.0;
+
+    rfft_double(tmpPartIR.data(), spectrum, nfft);
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
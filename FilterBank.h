@@ -0,0 +1,152 @@
+/*-----------------------------------------------------------------------------*\
+| Header of FilterBank.cpp, for explanation see cpp-file.                       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef FILTERBANK_H
+#define FILTERBANK_H
+
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include "fft.h"
+
+class MappedFile;
+
+class FilterBank
+{
+
+public:
+    // storage of the filter spectra, see getReducedParts()
+    enum Precision
+    {
+        PRECISION_FLOAT64 = 0,
+        PRECISION_FLOAT32 = 1,
+        PRECISION_BFLOAT16 = 2,
+        PRECISION_INT16 = 3
+    };
+
+    // copies numSamples samples of channel chanIdx of IR irIdx, starting at sampleBeg, to dest,
+    // returns -1 on error. Called from all build threads at once if numBuildThreads > 1.
+    typedef int (*IRProvider)(void *context, uint32_t irIdx, uint32_t chanIdx, uint32_t sampleBeg,
+            uint32_t numSamples, double *dest);
+
+    // interleavedIR holds numIR*numChansIR*lenIR samples (channels of an IR one after another), the
+    // spectra are transformed on numBuildThreads threads (0 = all cores) with identical results
+    FilterBank(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+            uint32_t blockLen, uint32_t numBuildThreads = 1);
+    FilterBank(IRProvider provider, void *context, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+            uint32_t blockLen, uint32_t numBuildThreads = 1);
+
+    // precomputed spectra written by TVOLAP::saveFilterSpectra(), mapped without copy
+    FilterBank(const char *spectraFile);
+
+    // copy of a float64 bank with the spectra rounded to another precision, partitions with identical
+    // spectra stay shared. getSnrDB() reports the energy of the spectra relative to the rounding error.
+    FilterBank(const FilterBank &source, Precision precision);
+    ~FilterBank();
+
+    // zero pads partLen samples to tmpPartIR.size() and transforms them
+    static void transformPartition(const double *partIR, uint32_t partLen, complex_float64 *spectrum,
+            std::vector<double> &tmpPartIR);
+
+    // numChansIR*numParts partitions of one IR, ordered channel, partition (NULL in reduced precision)
+    inline const complex_float64 * const *getParts(uint32_t irIdx) const
+    {
+        return parts.empty() ? NULL : &parts[uint64_t(irIdx)*numChansIR*numParts];
+    }
+
+    // partitions of a bank in reduced precision, ordered like getParts() (NULL in float64), each one
+    // 2*blockLen+1 bins of: complex_float32 (float32), re and im as the upper 16 bits of a float32
+    // (bfloat16), or a double block scale followed by int16 re and im, bin = mantissa*scale (int16)
+    inline const void * const *getReducedParts(uint32_t irIdx) const
+    {
+        return reducedParts.empty() ? NULL : &reducedParts[uint64_t(irIdx)*numChansIR*numParts];
+    }
+
+    inline Precision getPrecision() const
+    {
+        return precision;
+    }
+
+    inline double getSnrDB() const
+    {
+        return snrDB;
+    }
+
+    inline uint32_t getBlockLen() const
+    {
+        return blockLen;
+    }
+
+    inline uint32_t getNumIR() const
+    {
+        return numIR;
+    }
+
+    inline uint32_t getNumChansIR() const
+    {
+        return numChansIR;
+    }
+
+    inline uint32_t getLenIR() const
+    {
+        return numParts*processLen;
+    }
+
+    // partitions with identical spectra are stored once, getNumParts() counts all of them
+    inline uint32_t getNumParts() const
+    {
+        return uint32_t(parts.size());
+    }
+
+    inline uint32_t getNumUniqueParts() const
+    {
+        return numUniqueParts;
+    }
+
+    // heap memory of spectra and partition table, a mapped spectra file is not included
+    uint64_t getNumBytes() const;
+
+private:
+    struct Build;
+
+    FilterBank(const FilterBank &);
+    FilterBank &operator=(const FilterBank &);
+
+    void init(uint32_t numIR, uint32_t lenIR, uint32_t numChansIR, uint32_t blockLen);
+    void build(IRProvider provider, void *context, const double *interleavedIR, uint32_t lenIR, uint32_t numBuildThreads);
+    complex_float64 *appendPart();
+
+    static double reducePartition(const complex_float64 *spectrum, uint32_t numBins, Precision precision, void *dest);
+
+    uint32_t blockLen, processLen, nfft, numIR, numChansIR, numParts, numUniqueParts, partsPerChunk;
+    Precision precision;
+    double snrDB;
+    std::vector< std::vector<complex_float64> > binChunks;
+    std::vector<const complex_float64 *> parts;
+    std::vector<uint64_t> reducedData;
+    std::vector<const void *> reducedParts;
+    std::unique_ptr<MappedFile> file;
+};
+
+#endif // FILTERBANK_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
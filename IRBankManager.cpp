@@ -0,0 +1,488 @@
+/*-----------------------------------------------------------------------------*\
+| Hot reload of IR bank files. The manager keeps the samples of every           |
+| registered bank file and watches the directories of the files with inotify    |
+| (so files that are replaced by a rename are seen as well). When a file was    |
+| written, it is read again on the watcher thread, compared IR by IR with the   |
+| last version, and every changed IR is marked as pending for each attached     |
+| instance. All IRs that an instance has pending are transformed once into a    |
+| FilterBank on the watcher thread, shared by every instance with the same      |
+| block length and partitions, and staged with stageIRs() without holding the   |
+| manager lock. Each instance swaps the whole batch in at its next block        |
+| boundary with the windowed switch, so running sessions keep their overlap     |
+| state and audio. An instance that has not taken its previous batch yet (e.g.  |
+| a paused session) is not waited for, its IRs stay pending and are retried,    |
+| and a file of the wrong size (e.g. still being written) is ignored until the  |
+| next write.                                                                   |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <fstream>
+#include "ThreadPool.h"
+#include "IRBankManager.h"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#define IRBANK_RETRY_MS 100
+#define IRBANK_EVENT_BUFFER_SIZE 4096
+
+struct IRBankManager::Bank
+{
+    std::string dirName, baseName, fileName;
+    uint32_t numIR, lenIR, numChansIR;
+    int watchDesc;
+    std::vector<double> samples;
+    std::vector< std::unique_ptr<Attached> > instances;
+    std::atomic<uint64_t> numReloads, numChangedIRs, numRejected;
+};
+
+struct IRBankManager::Attached
+{
+    TVOLAP *inst;
+    // IRs of the bank file that the instance has not taken yet
+    std::vector<bool> pending;
+};
+
+// the changed IRs of a bank transformed once for all instances with the same partitioning
+struct IRBankManager::Batch
+{
+    const Bank *bank;
+    uint32_t blockLen, maxLenIR;
+    std::vector<uint32_t> irIdx;
+    std::shared_ptr<const FilterBank> filterBank;
+};
+
+IRBankManager::IRBankManager()
+{
+    quit.store(false);
+    notifyFd = wakeFd[0] = wakeFd[1] = -1;
+    busyInst = NULL;
+}
+
+IRBankManager::~IRBankManager()
+{
+    stop();
+}
+
+int IRBankManager::addBank(const char *fileName, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR)
+{
+    std::unique_ptr<Bank> bank(new Bank);
+    std::string::size_type slashPos;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (fileName == NULL || numIR == 0 || lenIR == 0 || numChansIR == 0)
+        return -1;
+
+    bank->fileName = fileName;
+    slashPos = bank->fileName.rfind('/');
+    bank->dirName = slashPos == std::string::npos ? std::string(".") : bank->fileName.substr(0, std::max(slashPos, std::string::size_type(1)));
+    bank->baseName = slashPos == std::string::npos ? bank->fileName : bank->fileName.substr(slashPos+1);
+    bank->numIR = numIR;
+    bank->lenIR = lenIR;
+    bank->numChansIR = numChansIR;
+    bank->watchDesc = -1;
+    bank->numReloads.store(0);
+    bank->numChangedIRs.store(0);
+    bank->numRejected.store(0);
+
+    if (!readBank(*bank, bank->samples))
+        return -1;
+
+    if (notifyFd >= 0 && addWatch(*bank) < 0)
+        return -1;
+
+    banks.push_back(std::move(bank));
+
+    return int(banks.size()-1);
+}
+
+int IRBankManager::attach(uint32_t bankId, TVOLAP *inst)
+{
+    std::unique_ptr<Attached> attached;
+    uint32_t instCnt;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (bankId >= banks.size() || inst == NULL)
+        return -1;
+
+    for (instCnt=0; instCnt<banks[bankId]->instances.size(); instCnt++)
+    {
+        if (banks[bankId]->instances[instCnt]->inst == inst)
+            return 0;
+    }
+
+    attached.reset(new Attached);
+    attached->inst = inst;
+    attached->pending.resize(banks[bankId]->numIR, false);
+    banks[bankId]->instances.push_back(std::move(attached));
+
+    return 0;
+}
+
+int IRBankManager::detach(uint32_t bankId, TVOLAP *inst)
+{
+    uint32_t instCnt;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (bankId >= banks.size())
+        return -1;
+
+    // only a swap into this instance is waited for, the lock is not held during swaps
+    while (busyInst == inst)
+        swapDone.wait(lock);
+
+    for (instCnt=0; instCnt<banks[bankId]->instances.size(); instCnt++)
+    {
+        if (banks[bankId]->instances[instCnt]->inst == inst)
+        {
+            banks[bankId]->instances.erase(banks[bankId]->instances.begin()+instCnt);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+int IRBankManager::getStats(uint32_t bankId, BankStats &stats) const
+{
+    uint32_t instCnt;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (bankId >= banks.size())
+        return -1;
+
+    stats.numReloads = banks[bankId]->numReloads.load(std::memory_order_relaxed);
+    stats.numChangedIRs = banks[bankId]->numChangedIRs.load(std::memory_order_relaxed);
+    stats.numRejected = banks[bankId]->numRejected.load(std::memory_order_relaxed);
+    stats.numPending = 0;
+    for (instCnt=0; instCnt<banks[bankId]->instances.size(); instCnt++)
+    {
+        const std::vector<bool> &pending = banks[bankId]->instances[instCnt]->pending;
+        stats.numPending += uint64_t(std::count(pending.begin(), pending.end(), true));
+    }
+
+    return 0;
+}
+
+bool IRBankManager::readBank(const Bank &bank, std::vector<double> &samples) const
+{
+    uint64_t numSamples = uint64_t(bank.numIR)*bank.numChansIR*bank.lenIR;
+    std::ifstream file(bank.fileName.c_str(), std::ios::binary);
+
+    if (!file.is_open())
+        return false;
+
+    file.seekg(0, std::ios::end);
+    if (uint64_t(file.tellg()) != numSamples*sizeof(double))
+        return false;
+
+    samples.resize(numSamples);
+    file.seekg(0, std::ios::beg);
+    file.read((char *) samples.data(), std::streamsize(numSamples*sizeof(double)));
+
+    return bool(file);
+}
+
+#if defined(__linux__)
+
+int IRBankManager::start(int cpuIdx)
+{
+    uint32_t bankCnt;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (notifyFd >= 0)
+        return -1;
+
+    notifyFd = inotify_init1(IN_CLOEXEC);
+    if (notifyFd < 0)
+        return -1;
+
+    if (pipe(wakeFd) < 0)
+    {
+        close(notifyFd);
+        notifyFd = -1;
+        return -1;
+    }
+
+    for (bankCnt=0; bankCnt<banks.size(); bankCnt++)
+        addWatch(*banks[bankCnt]);
+
+    quit.store(false);
+    watcher = std::thread(&IRBankManager::watchLoop, this, cpuIdx);
+
+    return 0;
+}
+
+void IRBankManager::stop()
+{
+    char wake = 0;
+    ssize_t numWritten;
+
+    if (!watcher.joinable())
+        return;
+
+    quit.store(true);
+    numWritten = write(wakeFd[1], &wake, 1);
+    (void) numWritten;
+    watcher.join();
+
+    close(notifyFd);
+    close(wakeFd[0]);
+    close(wakeFd[1]);
+    notifyFd = wakeFd[0] = wakeFd[1] = -1;
+}
+
+int IRBankManager::addWatch(Bank &bank)
+{
+    // an editor may replace the file by a new one, the directory sees both kinds of writes
+    bank.watchDesc = inotify_add_watch(notifyFd, bank.dirName.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    return bank.watchDesc < 0 ? -1 : 0;
+}
+
+void IRBankManager::watchLoop(int cpuIdx)
+{
+    char buffer[IRBANK_EVENT_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2];
+    const struct inotify_event *event;
+    std::vector<Bank *> changed;
+    ssize_t numBytes;
+    uint32_t bankCnt;
+    char *eventPos;
+    bool hasPending = false;
+
+    if (cpuIdx >= 0)
+        ThreadPool::setThreadAffinity(uint32_t(cpuIdx));
+
+    fds[0].fd = notifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wakeFd[0];
+    fds[1].events = POLLIN;
+
+    while (!quit.load())
+    {
+        // IRs that an instance did not take are retried after a while
+        if (poll(fds, 2, hasPending ? IRBANK_RETRY_MS : -1) < 0 || (fds[1].revents & POLLIN))
+            continue;
+
+        if (fds[0].revents & POLLIN)
+        {
+            numBytes = read(notifyFd, buffer, sizeof(buffer));
+
+            changed.clear();
+            if (numBytes > 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                for (eventPos=buffer; eventPos<buffer+numBytes; eventPos+=sizeof(struct inotify_event)+event->len)
+                {
+                    event = (const struct inotify_event *) eventPos;
+                    for (bankCnt=0; bankCnt<banks.size(); bankCnt++)
+                    {
+                        if (event->len > 0 && event->wd == banks[bankCnt]->watchDesc && banks[bankCnt]->baseName == event->name &&
+                                std::find(changed.begin(), changed.end(), banks[bankCnt].get()) == changed.end())
+                            changed.push_back(banks[bankCnt].get());
+                    }
+                }
+            }
+
+            // banks are never removed, so the pointers stay valid without the lock
+            for (bankCnt=0; bankCnt<changed.size() && !quit.load(); bankCnt++)
+                reloadBank(*changed[bankCnt]);
+        }
+
+        hasPending = swapPending();
+    }
+}
+
+#else
+
+int IRBankManager::start(int cpuIdx)
+{
+    (void) cpuIdx;
+
+    return -1;
+}
+
+void IRBankManager::stop()
+{
+}
+
+int IRBankManager::addWatch(Bank &bank)
+{
+    (void) bank;
+
+    return -1;
+}
+
+void IRBankManager::watchLoop(int cpuIdx)
+{
+    (void) cpuIdx;
+}
+
+#endif
+
+void IRBankManager::reloadBank(Bank &bank)
+{
+    uint32_t irCnt, instCnt, irSize = bank.numChansIR*bank.lenIR;
+    std::vector<double> samples;
+
+    // only the watcher thread changes the samples of a bank, so the file is read without the lock
+    if (!readBank(bank, samples))
+    {
+        bank.numRejected.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bank.numReloads.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (irCnt=0; irCnt<bank.numIR; irCnt++)
+    {
+        if (std::equal(samples.begin()+uint64_t(irCnt)*irSize, samples.begin()+uint64_t(irCnt+1)*irSize,
+                bank.samples.begin()+uint64_t(irCnt)*irSize))
+            continue;
+
+        std::copy(samples.begin()+uint64_t(irCnt)*irSize, samples.begin()+uint64_t(irCnt+1)*irSize, bank.samples.begin()+uint64_t(irCnt)*irSize);
+        bank.numChangedIRs.fetch_add(1, std::memory_order_relaxed);
+
+        for (instCnt=0; instCnt<bank.instances.size(); instCnt++)
+            bank.instances[instCnt]->pending[irCnt] = true;
+    }
+}
+
+bool IRBankManager::swapPending()
+{
+    std::vector<const Attached *> failed;
+    std::vector< std::unique_ptr<Batch> > batches;
+    std::vector<uint32_t> irIdx;
+    Attached *job;
+    Bank *jobBank = NULL;
+    Batch *batch;
+    uint32_t bankCnt, instCnt, irCnt, batchCnt, blockLen, maxLenIR;
+    bool hasPending, swapped;
+
+    while (!quit.load())
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // next instance with IRs it has not taken, instances that failed in this round are skipped
+        job = NULL;
+        hasPending = false;
+        for (bankCnt=0; bankCnt<banks.size() && job == NULL; bankCnt++)
+        {
+            for (instCnt=0; instCnt<banks[bankCnt]->instances.size() && job == NULL; instCnt++)
+            {
+                Attached &attached = *banks[bankCnt]->instances[instCnt];
+
+                if (std::find(attached.pending.begin(), attached.pending.end(), true) == attached.pending.end())
+                    continue;
+
+                hasPending = true;
+                if (std::find(failed.begin(), failed.end(), &attached) == failed.end())
+                {
+                    job = &attached;
+                    jobBank = banks[bankCnt].get();
+                }
+            }
+        }
+
+        if (job == NULL)
+            return hasPending;
+
+        irIdx.clear();
+        for (irCnt=0; irCnt<job->pending.size(); irCnt++)
+        {
+            if (job->pending[irCnt])
+                irIdx.push_back(irCnt);
+        }
+
+        // detach() of this instance waits until the swap is done, the record stays valid
+        busyInst = job->inst;
+        lock.unlock();
+
+        // the pending IRs go in as one batch, instances with the same partitioning share its spectra
+        blockLen = job->inst->getBlockLen();
+        maxLenIR = job->inst->getMaxLenIR();
+        batch = NULL;
+        for (batchCnt=0; batchCnt<batches.size() && batch == NULL; batchCnt++)
+        {
+            if (batches[batchCnt]->bank == jobBank && batches[batchCnt]->blockLen == blockLen &&
+                    batches[batchCnt]->maxLenIR == maxLenIR && batches[batchCnt]->irIdx == irIdx)
+                batch = batches[batchCnt].get();
+        }
+
+        if (batch == NULL && jobBank->lenIR <= maxLenIR)
+        {
+            batches.push_back(std::unique_ptr<Batch>(new Batch));
+            batch = batches.back().get();
+            batch->bank = jobBank;
+            batch->blockLen = blockLen;
+            batch->maxLenIR = maxLenIR;
+            batch->irIdx = irIdx;
+            batch->filterBank.reset(new FilterBank(&IRBankManager::provideIR, batch, uint32_t(irIdx.size()), maxLenIR,
+                    jobBank->numChansIR, blockLen));
+        }
+
+        // an instance that has not swapped in its previous batch yet is not waited for
+        swapped = batch != NULL && job->inst->stageIRs(irIdx, batch->filterBank) == 0 && job->inst->publishIR() == 0;
+
+        lock.lock();
+        busyInst = NULL;
+        if (swapped)
+        {
+            for (irCnt=0; irCnt<irIdx.size(); irCnt++)
+                job->pending[irIdx[irCnt]] = false;
+        }
+        else
+        {
+            jobBank->numRejected.fetch_add(1, std::memory_order_relaxed);
+            failed.push_back(job);
+        }
+        swapDone.notify_all();
+    }
+
+    return false;
+}
+
+int IRBankManager::provideIR(void *context, uint32_t irIdx, uint32_t chanIdx, uint32_t sampleBeg, uint32_t numSamples, double *dest)
+{
+    const Batch &batch = *(const Batch *) context;
+    const Bank &bank = *batch.bank;
+    uint32_t numCopied = 0;
+
+    // runs on the watcher thread, the only one that changes the samples
+    if (sampleBeg < bank.lenIR)
+    {
+        numCopied = std::min(numSamples, bank.lenIR-sampleBeg);
+        std::copy(bank.samples.begin()+(uint64_t(batch.irIdx[irIdx])*bank.numChansIR+chanIdx)*bank.lenIR+sampleBeg,
+                bank.samples.begin()+(uint64_t(batch.irIdx[irIdx])*bank.numChansIR+chanIdx)*bank.lenIR+sampleBeg+numCopied, dest);
+    }
+    std::fill(dest+numCopied, dest+numSamples, 0.0);
+
+    return 0;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,91 @@
+/*-----------------------------------------------------------------------------*\
+| Header of IRBankManager.cpp, for explanation see cpp-file.                    |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef IRBANKMANAGER_H
+#define IRBANKMANAGER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "TVOLAP.h"
+
+class IRBankManager
+{
+
+public:
+    // numRejected counts reloads of a file with the wrong size and failed swaps into an instance (retried
+    // later), numPending the changed IRs that the attached instances have not taken yet
+    struct BankStats
+    {
+        uint64_t numReloads, numChangedIRs, numRejected, numPending;
+    };
+
+    IRBankManager();
+    ~IRBankManager();
+
+    // raw float64 IR bank file in the layout of the TVOLAP(irBankFile, ...) constructor,
+    // returns the bank id or -1 if the file cannot be read or has the wrong size
+    int addBank(const char *fileName, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR);
+
+    // running instances that get the changed IRs of a bank (via stageIRs() / publishIR()), an
+    // instance must be detached before it is destroyed, detach() waits while the watcher stages into it
+    int attach(uint32_t bankId, TVOLAP *inst);
+    int detach(uint32_t bankId, TVOLAP *inst);
+
+    // watches the directories of the bank files on a background thread (Linux only, -1 elsewhere)
+    int start(int cpuIdx = -1);
+    void stop();
+
+    int getStats(uint32_t bankId, BankStats &stats) const;
+
+private:
+    struct Bank;
+    struct Attached;
+    struct Batch;
+
+    IRBankManager(const IRBankManager &);
+    IRBankManager &operator=(const IRBankManager &);
+
+    bool readBank(const Bank &bank, std::vector<double> &samples) const;
+    int addWatch(Bank &bank);
+    void reloadBank(Bank &bank);
+    bool swapPending();
+    static int provideIR(void *context, uint32_t irIdx, uint32_t chanIdx, uint32_t sampleBeg, uint32_t numSamples, double *dest);
+    void watchLoop(int cpuIdx);
+
+    std::vector< std::unique_ptr<Bank> > banks;
+    mutable std::mutex mutex;
+    std::condition_variable swapDone;
+    TVOLAP *busyInst;
+    std::thread watcher;
+    std::atomic<bool> quit;
+    int notifyFd, wakeFd[2];
+};
+
+#endif // IRBANKMANAGER_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,130 @@
+/*-----------------------------------------------------------------------------*\
+| Read only memory mapping of a whole file, so large IR banks and precomputed   |
+| filter spectra are paged in by the operating system on demand instead of      |
+| being read into the heap. POSIX mmap, file mapping objects on Windows.        |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::MappedFile()
+{
+    data = NULL;
+    size = 0;
+    fileHandle = NULL;
+    mapHandle = NULL;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+int MappedFile::open(const char *fileName)
+{
+    close();
+
+#if defined(_WIN32)
+    LARGE_INTEGER fileSize;
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return -1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return -1;
+    }
+
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return -1;
+    }
+
+    fileHandle = file;
+    mapHandle = mapping;
+    size = uint64_t(fileSize.QuadPart);
+#else
+    struct stat fileStat;
+    int file = ::open(fileName, O_RDONLY);
+
+    if (file < 0)
+        return -1;
+
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(file);
+        return -1;
+    }
+
+    data = mmap(NULL, size_t(fileStat.st_size), PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED)
+    {
+        data = NULL;
+        return -1;
+    }
+
+    size = uint64_t(fileStat.st_size);
+#endif
+
+    return 0;
+}
+
+void MappedFile::close()
+{
+    if (data == NULL)
+        return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE) mapHandle);
+    CloseHandle((HANDLE) fileHandle);
+#else
+    munmap(data, size_t(size));
+#endif
+
+    data = NULL;
+    size = 0;
+    fileHandle = NULL;
+    mapHandle = NULL;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
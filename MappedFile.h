@@ -0,0 +1,60 @@
+/*-----------------------------------------------------------------------------*\
+| Header of MappedFile.cpp, for explanation see cpp-file.                       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stdint.h>
+
+class MappedFile
+{
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // maps the whole file read only, returns -1 if it cannot be opened or is empty
+    int open(const char *fileName);
+    void close();
+
+    inline const void *getData() const
+    {
+        return data;
+    }
+
+    inline uint64_t getSize() const
+    {
+        return size;
+    }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    void *data;
+    uint64_t size;
+    void *fileHandle, *mapHandle;
+};
+
+#endif // MAPPEDFILE_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
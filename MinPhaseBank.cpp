@@ -0,0 +1,207 @@
+/*-----------------------------------------------------------------------------*\
+| Minimum phase plus delay decomposition of IR banks. Measured IRs (e.g. HRIRs) |
+| often carry an onset delay and low energy pre-ringing that only cost          |
+| partitions. Every IR channel is converted to minimum phase by the folded real |
+| cepstrum (homomorphic filtering with the FFT of fft.cpp, oversampled to keep  |
+| cepstral aliasing small) and its delay is estimated from the peak of the      |
+| cross correlation between original and minimum phase IR, refined by parabolic |
+| interpolation. The fractional part of the delay is applied to the minimum     |
+| phase spectrum, the integer part is kept separately, so TVOLAP can realize it |
+| with its frequency delay line. The minimum phase IRs are truncated to their   |
+| significant length, the remaining error (mostly all pass components) is       |
+| measured against the original IRs.                                            |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include "MinPhaseBank.h"
+#include "complex_functions.h"
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+#define MINPHASE_FFT_OVERSAMPLING 8
+#define MINPHASE_MIN_FFT 64
+#define MINPHASE_FLOOR 1e-10
+
+MinPhaseBank::MinPhaseBank(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+        double truncDB)
+{
+    uint32_t nfft = MINPHASE_MIN_FFT, irCnt, chanCnt, sampleCnt, peakIdx, delayInt, sigLen, approxLen;
+    double peak, magFloor, delay, fracDelay, left, right, curve, energy, residual, tail, limit, orig, approx;
+    double sumEnergy = 0.0, sumResidual = 0.0, maxError = 0.0;
+    std::vector<double> timeBuf, cepstrum;
+    std::vector<complex_float64> spectrum, minSpectrum, cross;
+
+    if (interleavedIR == NULL)
+        throw std::runtime_error("Impulse response is missing.");
+
+    if (numIR == 0 || lenIR == 0 || numChansIR == 0)
+        throw std::runtime_error("Number of IRs, length of one IR and number of IR channels must be at least 1.");
+
+    while (nfft < MINPHASE_FFT_OVERSAMPLING*lenIR)
+        nfft *= 2;
+
+    this->numIR = numIR;
+    this->numChansIR = numChansIR;
+    this->maxDelay = 0;
+
+    timeBuf.resize(nfft);
+    cepstrum.resize(nfft);
+    spectrum.resize(nfft/2+1);
+    minSpectrum.resize(nfft/2+1);
+    cross.resize(nfft/2+1);
+    minPhaseIR.resize(uint64_t(numIR)*numChansIR*lenIR, 0.0);
+    delays.resize(uint64_t(numIR)*numChansIR, 0);
+
+    // the twiddle table of fft.cpp only grows, running instances keep the table they read
+    if (table_get_nfft() < int(nfft/2))
+        set_twiddle_table(int(nfft));
+
+    for (irCnt=0; irCnt<numIR; irCnt++)
+    {
+        for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+        {
+            const double *ir = &interleavedIR[(uint64_t(irCnt)*numChansIR+chanCnt)*lenIR];
+            double *minIR = &minPhaseIR[(uint64_t(irCnt)*numChansIR+chanCnt)*lenIR];
+
+            std::fill(timeBuf.begin(), timeBuf.end(), 0.0);
+            std::copy(ir, ir+lenIR, timeBuf.begin());
+            rfft_double(timeBuf.data(), spectrum.data(), nfft);
+
+            for (peak=0.0, sampleCnt=0; sampleCnt<nfft/2+1; sampleCnt++)
+                peak = std::max(peak, complex_abs(spectrum[sampleCnt]));
+
+            if (peak == 0.0)
+                continue;
+
+            // real cepstrum of the log magnitude, limited to keep the log of spectral zeros finite
+            magFloor = peak*MINPHASE_FLOOR;
+            for (sampleCnt=0; sampleCnt<nfft/2+1; sampleCnt++)
+                minSpectrum[sampleCnt] = complex(log(std::max(complex_abs(spectrum[sampleCnt]), magFloor)), 0.0);
+
+            irfft_double(minSpectrum.data(), cepstrum.data(), nfft);
+
+            // folding the anti causal part onto the causal one gives the minimum phase cepstrum
+            for (sampleCnt=1; sampleCnt<nfft/2; sampleCnt++)
+            {
+                cepstrum[sampleCnt] *= 2.0;
+                cepstrum[nfft-sampleCnt] = 0.0;
+            }
+
+            rfft_double(cepstrum.data(), minSpectrum.data(), nfft);
+            for (sampleCnt=0; sampleCnt<nfft/2+1; sampleCnt++)
+            {
+                minSpectrum[sampleCnt] = complex_mulr(complex(cos(minSpectrum[sampleCnt].im), sin(minSpectrum[sampleCnt].im)),
+                        exp(minSpectrum[sampleCnt].re));
+                cross[sampleCnt] = complex_mul(spectrum[sampleCnt], complex_conj(minSpectrum[sampleCnt]));
+            }
+
+            irfft_double(cross.data(), timeBuf.data(), nfft);
+
+            for (peakIdx=0, sampleCnt=1; sampleCnt<lenIR; sampleCnt++)
+            {
+                if (timeBuf[sampleCnt] > timeBuf[peakIdx])
+                    peakIdx = sampleCnt;
+            }
+
+            left = timeBuf[peakIdx > 0 ? peakIdx-1 : nfft-1];
+            right = timeBuf[peakIdx+1];
+            curve = left-2.0*timeBuf[peakIdx]+right;
+            delay = double(peakIdx)+(curve < 0.0 ? 0.5*(left-right)/curve : 0.0);
+            delay = std::max(delay, 0.0);
+            delayInt = uint32_t(delay);
+            fracDelay = delay-double(delayInt);
+
+            delays[uint64_t(irCnt)*numChansIR+chanCnt] = delayInt;
+            maxDelay = std::max(maxDelay, delayInt);
+
+            for (sampleCnt=0; sampleCnt<nfft/2+1; sampleCnt++)
+            {
+                minSpectrum[sampleCnt] = complex_mul(minSpectrum[sampleCnt],
+                        complex(cos(2.0*M_PI*sampleCnt*fracDelay/nfft), -sin(2.0*M_PI*sampleCnt*fracDelay/nfft)));
+            }
+
+            irfft_double(minSpectrum.data(), timeBuf.data(), nfft);
+            std::copy(timeBuf.begin(), timeBuf.begin()+lenIR, minIR);
+        }
+    }
+
+    // significant length: the longest of all IR channels without the tail below truncDB
+    this->lenIR = 1;
+    for (irCnt=0; irCnt<numIR*numChansIR; irCnt++)
+    {
+        const double *minIR = &minPhaseIR[uint64_t(irCnt)*lenIR];
+
+        for (energy=0.0, sampleCnt=0; sampleCnt<lenIR; sampleCnt++)
+            energy += minIR[sampleCnt]*minIR[sampleCnt];
+
+        limit = energy*pow(10.0, truncDB/10.0);
+        for (tail=0.0, sigLen=lenIR; sigLen>this->lenIR; sigLen--)
+        {
+            tail += minIR[sigLen-1]*minIR[sigLen-1];
+            if (tail > limit)
+                break;
+        }
+
+        this->lenIR = std::max(this->lenIR, sigLen);
+    }
+
+    for (irCnt=0; irCnt<numIR; irCnt++)
+    {
+        for (energy=residual=0.0, chanCnt=0; chanCnt<numChansIR; chanCnt++)
+        {
+            const double *ir = &interleavedIR[(uint64_t(irCnt)*numChansIR+chanCnt)*lenIR];
+            const double *minIR = &minPhaseIR[(uint64_t(irCnt)*numChansIR+chanCnt)*lenIR];
+
+            delayInt = delays[uint64_t(irCnt)*numChansIR+chanCnt];
+            approxLen = std::max(lenIR, delayInt+this->lenIR);
+            for (sampleCnt=0; sampleCnt<approxLen; sampleCnt++)
+            {
+                orig = sampleCnt < lenIR ? ir[sampleCnt] : 0.0;
+                approx = sampleCnt >= delayInt && sampleCnt-delayInt < this->lenIR ? minIR[sampleCnt-delayInt] : 0.0;
+                energy += orig*orig;
+                residual += (orig-approx)*(orig-approx);
+            }
+        }
+
+        sumEnergy += energy;
+        sumResidual += residual;
+        if (energy > 0.0)
+            maxError = std::max(maxError, residual/energy);
+    }
+
+    errorDB = 10.0*log10(std::max(sumEnergy > 0.0 ? sumResidual/sumEnergy : 0.0, 1e-300));
+    maxErrorDB = 10.0*log10(std::max(maxError, 1e-300));
+
+    // the truncated IRs move to the front, every IR channel starts at or before its old position
+    for (irCnt=0; irCnt<numIR*numChansIR; irCnt++)
+    {
+        std::copy(minPhaseIR.begin()+uint64_t(irCnt)*lenIR, minPhaseIR.begin()+uint64_t(irCnt)*lenIR+this->lenIR,
+                minPhaseIR.begin()+uint64_t(irCnt)*this->lenIR);
+    }
+    minPhaseIR.resize(uint64_t(numIR)*numChansIR*this->lenIR);
+    minPhaseIR.shrink_to_fit();
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
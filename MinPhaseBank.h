@@ -0,0 +1,94 @@
+/*-----------------------------------------------------------------------------*\
+| Header of MinPhaseBank.cpp, for explanation see cpp-file.                     |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef MINPHASEBANK_H
+#define MINPHASEBANK_H
+
+#include <stdint.h>
+#include <vector>
+#include "fft.h"
+
+class MinPhaseBank
+{
+
+public:
+    // interleavedIR in the layout of FilterBank, every IR channel is split into a minimum phase IR
+    // (including the fractional part of its delay) and an integer delay, the minimum phase IRs are
+    // truncated where the energy of the rest of every IR is below truncDB relative to the IR energy
+    MinPhaseBank(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+            double truncDB = -60.0);
+
+    // numIR*numChansIR*getLenIR() samples in the layout of interleavedIR
+    inline const double *getIR() const
+    {
+        return minPhaseIR.data();
+    }
+
+    // delay in samples of channel chanIdx of IR irIdx
+    inline uint32_t getDelay(uint32_t irIdx, uint32_t chanIdx) const
+    {
+        return delays[uint64_t(irIdx)*numChansIR+chanIdx];
+    }
+
+    inline uint32_t getMaxDelay() const
+    {
+        return maxDelay;
+    }
+
+    inline uint32_t getNumIR() const
+    {
+        return numIR;
+    }
+
+    inline uint32_t getNumChansIR() const
+    {
+        return numChansIR;
+    }
+
+    // length of the truncated minimum phase IRs
+    inline uint32_t getLenIR() const
+    {
+        return lenIR;
+    }
+
+    // energy of the difference between delayed minimum phase IR and original IR relative to the IR
+    // energy in dB, of the whole bank and of the worst IR (all pass components are not represented)
+    inline double getErrorDB() const
+    {
+        return errorDB;
+    }
+
+    inline double getMaxErrorDB() const
+    {
+        return maxErrorDB;
+    }
+
+private:
+    uint32_t numIR, numChansIR, lenIR, maxDelay;
+    double errorDB, maxErrorDB;
+    std::vector<double> minPhaseIR;
+    std::vector<uint32_t> delays;
+};
+
+#endif // MINPHASEBANK_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
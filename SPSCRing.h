@@ -0,0 +1,178 @@
+/*-----------------------------------------------------------------------------*\
+| Lock-free single producer / single consumer ring of preallocated slots. The   |
+| producer fills writeSlot() and publishes it by push(), the consumer reads     |
+| readSlot() and frees it by pop(). Both counters are free running, so the     |
+| fill level stays correct across the 32 bit wrap around. Waiting sides spin    |
+| for a short while and then sleep on the counter they wait for.                |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "ThreadPool.h"
+
+#define SPSC_SPIN_CNT_BEFORE_SLEEP 16384
+
+template <typename T>
+class SPSCRing
+{
+
+public:
+    SPSCRing(uint32_t numSlots, const T &initSlot)
+        : slots(numSlots, initSlot)
+    {
+        this->numSlots = numSlots;
+        this->writeIdx = 0;
+        this->readIdx = 0;
+        writeCnt.store(0);
+        readCnt.store(0);
+        sleepers.store(0);
+    }
+
+    inline uint32_t getNumSlots() const
+    {
+        return numSlots;
+    }
+
+    // random access for consumers that keep a history of slots (e.g. a frequency delay line)
+    inline T &at(uint32_t slotIdx)
+    {
+        return slots[slotIdx];
+    }
+
+    inline uint32_t getWriteIdx() const
+    {
+        return writeIdx;
+    }
+
+    inline T &writeSlot()
+    {
+        return slots[writeIdx];
+    }
+
+    inline T &readSlot()
+    {
+        return slots[readIdx];
+    }
+
+    inline bool isReadable() const
+    {
+        return writeCnt.load(std::memory_order_acquire) != readCnt.load(std::memory_order_relaxed);
+    }
+
+    inline bool isWritable() const
+    {
+        return writeCnt.load(std::memory_order_relaxed)-readCnt.load(std::memory_order_acquire) < numSlots;
+    }
+
+    // number of slots published in total, consumers compare it to their own position
+    inline uint32_t getWriteCnt() const
+    {
+        return writeCnt.load(std::memory_order_acquire);
+    }
+
+    void push()
+    {
+        if (++writeIdx >= numSlots)
+            writeIdx = 0;
+        writeCnt.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0)
+            ThreadPool::futexWake(writeCnt);
+    }
+
+    void pop()
+    {
+        if (++readIdx >= numSlots)
+            readIdx = 0;
+        readCnt.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) > 0)
+            ThreadPool::futexWake(readCnt);
+    }
+
+    // wait until more than readPos slots were published, returns false if quit was raised
+    bool waitReadable(uint32_t readPos, const std::atomic<bool> &quit)
+    {
+        uint32_t actCnt, spinCnt = 0;
+
+        while ((actCnt = writeCnt.load(std::memory_order_acquire)) == readPos)
+        {
+            if (quit.load(std::memory_order_acquire))
+                return false;
+            sleepOn(writeCnt, actCnt, spinCnt);
+        }
+
+        return !quit.load(std::memory_order_acquire);
+    }
+
+    inline bool waitReadable(const std::atomic<bool> &quit)
+    {
+        return waitReadable(readCnt.load(std::memory_order_relaxed), quit);
+    }
+
+    bool waitWritable(const std::atomic<bool> &quit)
+    {
+        uint32_t actCnt, spinCnt = 0;
+
+        while (writeCnt.load(std::memory_order_relaxed)-(actCnt = readCnt.load(std::memory_order_acquire)) >= numSlots)
+        {
+            if (quit.load(std::memory_order_acquire))
+                return false;
+            sleepOn(readCnt, actCnt, spinCnt);
+        }
+
+        return !quit.load(std::memory_order_acquire);
+    }
+
+    // releases every waiting side after quit was raised, the ring must not be used afterwards
+    void wakeAll()
+    {
+        writeCnt.fetch_add(1, std::memory_order_seq_cst);
+        readCnt.fetch_add(1, std::memory_order_seq_cst);
+        ThreadPool::futexWake(writeCnt);
+        ThreadPool::futexWake(readCnt);
+    }
+
+private:
+    SPSCRing(const SPSCRing &);
+    SPSCRing &operator=(const SPSCRing &);
+
+    inline void sleepOn(std::atomic<uint32_t> &counter, uint32_t oldValue, uint32_t &spinCnt)
+    {
+        if (++spinCnt < SPSC_SPIN_CNT_BEFORE_SLEEP)
+            return;
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        ThreadPool::futexWait(counter, oldValue);
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        spinCnt = 0;
+    }
+
+    uint32_t numSlots, writeIdx, readIdx;
+    std::vector<T> slots;
+    std::atomic<uint32_t> writeCnt, readCnt, sleepers;
+};
+
+#endif // SPSCRING_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,378 @@
+/*-----------------------------------------------------------------------------*\
+| Earliest deadline first scheduling of many independent TVOLAP instances on a  |
+| fixed set of worker threads (instead of one thread per instance). Every       |
+| stream registers with the period of its audio callback. schedule() releases   |
+| one process() job with the deadline release time + period into a single ready |
+| heap ordered by deadline, every free worker pops the earliest job. The heap   |
+| is guarded by a short test-and-set lock that spins with a pause and           |
+| exponential backoff, it is held only for one O(log streams) heap operation,   |
+| schedule() on the audio thread never sleeps or allocates. Workers poll the    |
+| number of ready jobs without the lock. Deadline misses, overruns and the      |
+| worst lateness are counted per stream.                                        |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "StreamScheduler.h"
+#include "ThreadPool.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <immintrin.h>
+#define SCHED_CPU_PAUSE() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define SCHED_CPU_PAUSE() __asm__ __volatile__("yield")
+#else
+#define SCHED_CPU_PAUSE() std::atomic_signal_fence(std::memory_order_seq_cst)
+#endif
+
+#define SCHED_SPIN_CNT_BEFORE_SLEEP 16384
+#define SCHED_MAX_BACKOFF 64
+
+struct StreamScheduler::Stream
+{
+    TVOLAP *inst;
+    double *block;
+    int64_t periodNs, releaseNs, deadlineNs;
+    std::atomic<bool> used;
+    std::atomic<uint32_t> scheduledCnt, doneCnt, waiting;
+    std::atomic<uint64_t> numJobs, numMisses, numOverruns;
+    std::atomic<int64_t> maxLatenessNs, maxExecNs;
+};
+
+struct StreamScheduler::ReadyQueue
+{
+    std::atomic<bool> locked;
+    std::vector<uint32_t> heap;
+    std::atomic<uint32_t> numReady;
+};
+
+static inline int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+StreamScheduler::StreamScheduler(uint32_t numWorkers, uint32_t maxStreams, int firstCpu)
+{
+    uint32_t workerCnt, streamCnt, numCpus = std::max(std::thread::hardware_concurrency(), 1u);
+
+    if (numWorkers < 1 || maxStreams < 1)
+        throw std::runtime_error("Number of workers and number of streams must be at least one.");
+
+    this->numWorkers = numWorkers;
+    this->maxStreams = maxStreams;
+
+    streams.reset(new Stream[maxStreams]);
+    for (streamCnt=0; streamCnt<maxStreams; streamCnt++)
+    {
+        streams[streamCnt].inst = NULL;
+        streams[streamCnt].block = NULL;
+        streams[streamCnt].periodNs = streams[streamCnt].releaseNs = streams[streamCnt].deadlineNs = 0;
+        streams[streamCnt].used.store(false);
+        streams[streamCnt].scheduledCnt.store(0);
+        streams[streamCnt].doneCnt.store(0);
+        streams[streamCnt].waiting.store(0);
+    }
+
+    // the heap can take all streams, so schedule() never allocates
+    queue.reset(new ReadyQueue);
+    queue->locked.store(false);
+    queue->heap.reserve(maxStreams);
+    queue->numReady.store(0);
+
+    jobCnt.store(0);
+    sleepers.store(0);
+    quit.store(false);
+
+    workers.reserve(numWorkers);
+    for (workerCnt=0; workerCnt<numWorkers; workerCnt++)
+        workers.push_back(std::thread(&StreamScheduler::workerLoop, this,
+                firstCpu < 0 ? -1 : int((firstCpu+workerCnt)%numCpus)));
+}
+
+StreamScheduler::~StreamScheduler()
+{
+    uint32_t workerCnt;
+
+    quit.store(true, std::memory_order_seq_cst);
+    jobCnt.fetch_add(1, std::memory_order_seq_cst);
+    ThreadPool::futexWake(jobCnt);
+
+    for (workerCnt=0; workerCnt<workers.size(); workerCnt++)
+        workers[workerCnt].join();
+}
+
+int StreamScheduler::registerStream(TVOLAP *inst, uint32_t periodUs)
+{
+    std::lock_guard<std::mutex> guard(registerMutex);
+    uint32_t streamCnt;
+
+    if (inst == NULL || periodUs == 0)
+        return -1;
+
+    for (streamCnt=0; streamCnt<maxStreams; streamCnt++)
+    {
+        Stream &stream = streams[streamCnt];
+
+        if (stream.used.load(std::memory_order_acquire))
+            continue;
+
+        stream.inst = inst;
+        stream.block = NULL;
+        stream.periodNs = int64_t(periodUs)*1000;
+        stream.scheduledCnt.store(0);
+        stream.doneCnt.store(0);
+        stream.numJobs.store(0);
+        stream.numMisses.store(0);
+        stream.numOverruns.store(0);
+        stream.maxLatenessNs.store(0);
+        stream.maxExecNs.store(0);
+        stream.used.store(true, std::memory_order_release);
+
+        return int(streamCnt);
+    }
+
+    return -1;
+}
+
+int StreamScheduler::unregisterStream(uint32_t streamId)
+{
+    std::lock_guard<std::mutex> guard(registerMutex);
+
+    if (streamId >= maxStreams || !streams[streamId].used.load(std::memory_order_acquire) || !isDone(streamId))
+        return -1;
+
+    streams[streamId].used.store(false, std::memory_order_release);
+
+    return 0;
+}
+
+int StreamScheduler::schedule(uint32_t streamId, double *inBlockInterleaved)
+{
+    uint32_t heapPos, parentPos;
+
+    if (streamId >= maxStreams || !streams[streamId].used.load(std::memory_order_acquire))
+        return -1;
+
+    Stream &stream = streams[streamId];
+    ReadyQueue &queue = *this->queue;
+
+    if (!isDone(streamId))
+    {
+        stream.numOverruns.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    stream.block = inBlockInterleaved;
+    stream.releaseNs = nowNs();
+    stream.deadlineNs = stream.releaseNs+stream.periodNs;
+    stream.scheduledCnt.fetch_add(1, std::memory_order_seq_cst);
+
+    lockQueue();
+
+    // sift up in the deadline heap
+    heapPos = queue.heap.size();
+    queue.heap.push_back(streamId);
+    while (heapPos > 0)
+    {
+        parentPos = (heapPos-1)/2;
+        if (streams[queue.heap[parentPos]].deadlineNs <= stream.deadlineNs)
+            break;
+        queue.heap[heapPos] = queue.heap[parentPos];
+        heapPos = parentPos;
+    }
+    queue.heap[heapPos] = streamId;
+    queue.numReady.store(queue.heap.size(), std::memory_order_release);
+
+    queue.locked.store(false, std::memory_order_release);
+
+    jobCnt.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) > 0)
+        ThreadPool::futexWake(jobCnt);
+
+    return 0;
+}
+
+bool StreamScheduler::isDone(uint32_t streamId) const
+{
+    if (streamId >= maxStreams)
+        return true;
+
+    return streams[streamId].doneCnt.load(std::memory_order_acquire) == streams[streamId].scheduledCnt.load(std::memory_order_acquire);
+}
+
+int StreamScheduler::wait(uint32_t streamId)
+{
+    uint32_t doneCnt, spinCnt = 0;
+
+    if (streamId >= maxStreams || !streams[streamId].used.load(std::memory_order_acquire))
+        return -1;
+
+    Stream &stream = streams[streamId];
+
+    while ((doneCnt = stream.doneCnt.load(std::memory_order_seq_cst)) != stream.scheduledCnt.load(std::memory_order_relaxed))
+    {
+        if (++spinCnt < SCHED_SPIN_CNT_BEFORE_SLEEP)
+            continue;
+
+        stream.waiting.fetch_add(1, std::memory_order_seq_cst);
+        ThreadPool::futexWait(stream.doneCnt, doneCnt);
+        stream.waiting.fetch_sub(1, std::memory_order_seq_cst);
+        spinCnt = 0;
+    }
+
+    return 0;
+}
+
+int StreamScheduler::getStats(uint32_t streamId, StreamStats &stats) const
+{
+    if (streamId >= maxStreams || !streams[streamId].used.load(std::memory_order_acquire))
+        return -1;
+
+    stats.numJobs = streams[streamId].numJobs.load(std::memory_order_relaxed);
+    stats.numMisses = streams[streamId].numMisses.load(std::memory_order_relaxed);
+    stats.numOverruns = streams[streamId].numOverruns.load(std::memory_order_relaxed);
+    stats.maxLatenessNs = streams[streamId].maxLatenessNs.load(std::memory_order_relaxed);
+    stats.maxExecNs = streams[streamId].maxExecNs.load(std::memory_order_relaxed);
+
+    return 0;
+}
+
+void StreamScheduler::lockQueue()
+{
+    uint32_t pauseCnt, backoff = 1;
+
+    // test and test-and-set, waiting with growing pauses keeps the cache line quiet for the holder
+    while (queue->locked.exchange(true, std::memory_order_acquire))
+    {
+        do
+        {
+            for (pauseCnt=0; pauseCnt<backoff; pauseCnt++)
+                SCHED_CPU_PAUSE();
+            backoff = std::min(2*backoff, uint32_t(SCHED_MAX_BACKOFF));
+        } while (queue->locked.load(std::memory_order_relaxed));
+    }
+}
+
+bool StreamScheduler::popEarliest(uint32_t &streamIdx)
+{
+    uint32_t heapPos, childPos, heapSize, lastIdx;
+    ReadyQueue &queue = *this->queue;
+
+    // idle workers poll without the lock, so they do not delay schedule()
+    if (queue.numReady.load(std::memory_order_acquire) == 0)
+        return false;
+
+    lockQueue();
+
+    // another worker was faster
+    if (queue.heap.empty())
+    {
+        queue.locked.store(false, std::memory_order_release);
+        return false;
+    }
+
+    streamIdx = queue.heap[0];
+    lastIdx = queue.heap.back();
+    queue.heap.pop_back();
+    heapSize = queue.heap.size();
+
+    // sift down the last entry from the top
+    heapPos = 0;
+    while (heapSize > 0)
+    {
+        childPos = 2*heapPos+1;
+        if (childPos >= heapSize)
+            break;
+        if (childPos+1 < heapSize && streams[queue.heap[childPos+1]].deadlineNs < streams[queue.heap[childPos]].deadlineNs)
+            childPos++;
+        if (streams[lastIdx].deadlineNs <= streams[queue.heap[childPos]].deadlineNs)
+            break;
+        queue.heap[heapPos] = queue.heap[childPos];
+        heapPos = childPos;
+    }
+    if (heapSize > 0)
+        queue.heap[heapPos] = lastIdx;
+
+    queue.numReady.store(heapSize, std::memory_order_release);
+    queue.locked.store(false, std::memory_order_release);
+
+    return true;
+}
+
+void StreamScheduler::runJob(uint32_t streamIdx)
+{
+    Stream &stream = streams[streamIdx];
+    int64_t startNs, endNs;
+
+    startNs = nowNs();
+    stream.inst->process(stream.block);
+    endNs = nowNs();
+
+    // only one job per stream is in flight, so the statistics have a single writer
+    stream.numJobs.fetch_add(1, std::memory_order_relaxed);
+    if (endNs > stream.deadlineNs)
+        stream.numMisses.fetch_add(1, std::memory_order_relaxed);
+    if (endNs-stream.deadlineNs > stream.maxLatenessNs.load(std::memory_order_relaxed))
+        stream.maxLatenessNs.store(endNs-stream.deadlineNs, std::memory_order_relaxed);
+    if (endNs-startNs > stream.maxExecNs.load(std::memory_order_relaxed))
+        stream.maxExecNs.store(endNs-startNs, std::memory_order_relaxed);
+
+    stream.doneCnt.fetch_add(1, std::memory_order_seq_cst);
+    if (stream.waiting.load(std::memory_order_seq_cst) > 0)
+        ThreadPool::futexWake(stream.doneCnt);
+}
+
+void StreamScheduler::workerLoop(int cpuIdx)
+{
+    uint32_t actJobCnt, streamIdx, spinCnt = 0;
+
+    if (cpuIdx >= 0)
+        ThreadPool::setThreadAffinity(uint32_t(cpuIdx));
+
+    while (true)
+    {
+        actJobCnt = jobCnt.load(std::memory_order_seq_cst);
+        if (quit.load(std::memory_order_seq_cst))
+            break;
+
+        if (popEarliest(streamIdx))
+        {
+            runJob(streamIdx);
+            spinCnt = 0;
+            continue;
+        }
+
+        if (++spinCnt < SCHED_SPIN_CNT_BEFORE_SLEEP)
+        {
+            SCHED_CPU_PAUSE();
+            continue;
+        }
+
+        // schedule() bumps jobCnt after queueing, so a job queued meanwhile makes futexWait return
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        ThreadPool::futexWait(jobCnt, actJobCnt);
+        sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        spinCnt = 0;
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,82 @@
+/*-----------------------------------------------------------------------------*\
+| Header of StreamScheduler.cpp, for explanation see cpp-file.                  |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef STREAMSCHEDULER_H
+#define STREAMSCHEDULER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TVOLAP.h"
+
+class StreamScheduler
+{
+
+public:
+    struct StreamStats
+    {
+        uint64_t numJobs, numMisses, numOverruns;
+        int64_t maxLatenessNs, maxExecNs;
+    };
+
+    StreamScheduler(uint32_t numWorkers, uint32_t maxStreams, int firstCpu = -1);
+    ~StreamScheduler();
+
+    // returns the stream id or -1 if all stream slots are in use
+    int registerStream(TVOLAP *inst, uint32_t periodUs);
+    int unregisterStream(uint32_t streamId);
+
+    // queues inst->process(inBlockInterleaved) with the deadline now + period,
+    // returns -1 if the previous job of the stream is not finished yet (counted as overrun)
+    int schedule(uint32_t streamId, double *inBlockInterleaved);
+    bool isDone(uint32_t streamId) const;
+    int wait(uint32_t streamId);
+
+    int getStats(uint32_t streamId, StreamStats &stats) const;
+
+private:
+    struct Stream;
+    struct ReadyQueue;
+
+    StreamScheduler(const StreamScheduler &);
+    StreamScheduler &operator=(const StreamScheduler &);
+
+    void workerLoop(int cpuIdx);
+    void lockQueue();
+    bool popEarliest(uint32_t &streamIdx);
+    void runJob(uint32_t streamIdx);
+
+    uint32_t numWorkers, maxStreams;
+    std::unique_ptr<Stream[]> streams;
+    std::unique_ptr<ReadyQueue> queue;
+    std::atomic<uint32_t> jobCnt, sleepers;
+    std::atomic<bool> quit;
+    std::mutex registerMutex;
+    std::vector<std::thread> workers;
+};
+
+#endif // STREAMSCHEDULER_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -8,21 +8,100 @@
 \*-----------------------------------------------------------------------------*/
 
 #include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <thread>
 #include "TVOLAP.h"
+#include "MinPhaseBank.h"
+#include "ThreadPool.h"
+#include "TVOLAPAsync.h"
+#include "TVOLAPCache.h"
+#include "TVOLAPEvents.h"
+#include "TVOLAPPipeline.h"
 
 #define M_PI 3.14159265358979323846
 
 TVOLAP::TVOLAP(std::vector<double> &interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
-             uint32_t blockLen, uint32_t numChansAudio)
+             uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads)
 {
-    std::vector< std::vector< std::vector<double> > > tmpIR;
-    std::vector<double> tmpPartIR;
-    uint32_t intLenIR, irCnt = 0, chanCnt=0, convCnt=0, partCnt=0, memCnt=0, sampleCnt=0, cntIR=0;
-
     if (interleavedIR.size() != numIR*lenIR*numChansIR)
     	throw std::runtime_error("Size of interleaved impulse response is wrong."
     			"Must match number of IRs * length of one IR * number of IR channels.");
 
+    filterBank.reset(new FilterBank(interleavedIR.data(), numIR, lenIR, numChansIR, blockLen, numBuildThreads));
+    init(numIR, lenIR, numChansIR, blockLen, numChansAudio);
+}
+
+TVOLAP::TVOLAP(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+             uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads)
+{
+    filterBank.reset(new FilterBank(interleavedIR, numIR, lenIR, numChansIR, blockLen, numBuildThreads));
+    init(numIR, lenIR, numChansIR, blockLen, numChansAudio);
+}
+
+TVOLAP::TVOLAP(IRProvider provider, void *context, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+             uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads)
+{
+    filterBank.reset(new FilterBank(provider, context, numIR, lenIR, numChansIR, blockLen, numBuildThreads));
+    init(numIR, lenIR, numChansIR, blockLen, numChansAudio);
+}
+
+struct MinPhaseFilter
+{
+    const MinPhaseBank *bank;
+    uint32_t processLen;
+
+    // minimum phase IR behind the part of its delay that is shorter than a partition
+    static int provide(void *context, uint32_t irIdx, uint32_t chanIdx, uint32_t sampleBeg, uint32_t numSamples, double *dest)
+    {
+        MinPhaseFilter *filter = (MinPhaseFilter *) context;
+        uint32_t sampleCnt, delay = filter->bank->getDelay(irIdx, chanIdx)%filter->processLen, lenIR = filter->bank->getLenIR();
+        const double *ir = &filter->bank->getIR()[(uint64_t(irIdx)*filter->bank->getNumChansIR()+chanIdx)*lenIR];
+
+        for (sampleCnt=sampleBeg; sampleCnt<sampleBeg+numSamples; sampleCnt++)
+            dest[sampleCnt-sampleBeg] = sampleCnt >= delay && sampleCnt-delay < lenIR ? ir[sampleCnt-delay] : 0.0;
+
+        return 0;
+    }
+};
+
+TVOLAP::TVOLAP(const MinPhaseBank &minPhaseBank, uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads)
+{
+    MinPhaseFilter filter;
+    uint32_t irCnt, chanCnt, delay, maxRest = 0, numIR = minPhaseBank.getNumIR(), numChansIR = minPhaseBank.getNumChansIR();
+
+    filter.bank = &minPhaseBank;
+    filter.processLen = 2*blockLen;
+
+    partOffsets.resize(numIR*numChansIR);
+    for (irCnt=0; irCnt<numIR; irCnt++)
+    {
+        for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+        {
+            delay = minPhaseBank.getDelay(irCnt, chanCnt);
+            partOffsets.at(irCnt*numChansIR+chanCnt) = delay/filter.processLen;
+            maxRest = std::max(maxRest, delay%filter.processLen);
+        }
+    }
+
+    filterBank.reset(new FilterBank(&MinPhaseFilter::provide, &filter, numIR, minPhaseBank.getLenIR()+maxRest, numChansIR,
+            blockLen, numBuildThreads));
+    init(numIR, minPhaseBank.getLenIR()+maxRest, numChansIR, blockLen, numChansAudio);
+}
+
+TVOLAP::TVOLAP(std::shared_ptr<const FilterBank> filterBank, uint32_t numChansAudio)
+{
+    if (!filterBank)
+        throw std::runtime_error("Filter bank is missing.");
+
+    this->filterBank = filterBank;
+    init(filterBank->getNumIR(), filterBank->getLenIR(), filterBank->getNumChansIR(), filterBank->getBlockLen(), numChansAudio);
+}
+
+void TVOLAP::init(uint32_t numIR, uint32_t lenIR, uint32_t numChansIR, uint32_t blockLen, uint32_t numChansAudio)
+{
+    uint32_t intLenIR, irCnt=0, chanCnt=0, convCnt=0, memCnt=0, sampleCnt=0;
+
     this->blockLen = blockLen;
     this->numChansAudio = numChansAudio;
     this->numChansIR = numChansIR;
@@ -32,43 +111,32 @@ TVOLAP::TVOLAP(std::vector<double> &interleavedIR, uint32_t numIR, uint32_t lenI
     intLenIR = (((lenIR-1)/processLen+1)*processLen);
     this->numParts = intLenIR/processLen;
     this->overlapFact = 2;
-    this->numMems = numParts*overlapFact-1;
+
+    // without a minimum phase bank no IR is delayed
+    if (partOffsets.empty())
+        partOffsets.resize(numIR*numChansIR, 0);
+    this->maxPartOffset = *std::max_element(partOffsets.begin(), partOffsets.end());
+    // the frequency delay line keeps IR_EVENT_HISTORY blocks more to start event crossfades from
+    this->numMems = (numParts+maxPartOffset)*overlapFact-1+IR_EVENT_HISTORY;
     this->freqSaveCnt = 0;
     this->convSaveCnt = 0;
-    this->actIR = 0;
+    this->parallelMode = PARALLEL_OFF;
+    this->numPartTasks = 1;
+    this->jobChan = 0;
+    this->ioStride = numChansAudio;
+    this->ioFloat = false;
+
+    ioIn.resize(numChansAudio, NULL);
+    ioOut.resize(numChansAudio, NULL);
+
+    chanIR.resize(numChansIR, 0);
+    procIR.resize(numChansIR, 0);
 
     winVec.resize(processLen);
     for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
         winVec.at(sampleCnt) = 0.5-0.5*cos(2*M_PI*((double)sampleCnt/processLen));
 
-    inBlockWin.resize(nfft);
-    for (sampleCnt=0; sampleCnt<nfft; sampleCnt++)
-        inBlockWin.at(sampleCnt) = 0.0;
-
-    ifftBlock.resize(nfft);
-    for (sampleCnt=0; sampleCnt<nfft; sampleCnt++)
-        ifftBlock.at(sampleCnt) = 0.0;
-
-    inSpectrumSum.resize(processLen+1);
-
-    tmpIR.resize(numIR);
-	for (irCnt=0; irCnt<numIR; irCnt++)
-	{
-		tmpIR.at(irCnt).resize(numChansIR);
-		for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
-		{
-			tmpIR.at(irCnt).at(chanCnt).resize(intLenIR);
-			for (sampleCnt=0, cntIR=(irCnt*numChansIR+chanCnt)*lenIR; sampleCnt<lenIR; sampleCnt++, cntIR++)
-				tmpIR.at(irCnt).at(chanCnt).at(sampleCnt) = interleavedIR.at(cntIR);
-
-			for (sampleCnt=lenIR; sampleCnt<intLenIR; sampleCnt++)
-				tmpIR.at(irCnt).at(chanCnt).at(sampleCnt) = 0.0;
-		}
-	}
-
-    tmpPartIR.resize(nfft);
-    for (sampleCnt=0; sampleCnt<nfft; sampleCnt++)
-        tmpPartIR.at(sampleCnt) = 0.0;
+    resizeScratch(1);
 
     inBlock.resize(numChansAudio);
     for(chanCnt=0; chanCnt<numChansAudio; chanCnt++)
@@ -116,74 +184,146 @@ TVOLAP::TVOLAP(std::vector<double> &interleavedIR, uint32_t numIR, uint32_t lenI
         }
     }
 
-    filterSpectrum.resize(numIR);
-	for (irCnt=0; irCnt<numIR; irCnt++)
-	{
-		filterSpectrum.at(irCnt).resize(numChansIR);
-		for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
-		{
-			filterSpectrum.at(irCnt).at(chanCnt).resize(numParts);
-			for (partCnt=0; partCnt<numParts; partCnt++)
-			{
-				filterSpectrum.at(irCnt).at(chanCnt).at(partCnt).resize(processLen+1);
+    // the spectra of a shared filter bank are only referenced
+    irParts.resize(numIR, NULL);
+    irReduced.resize(numIR, NULL);
+    irLoaded.resize(numIR);
+    irShared.resize(numIR);
+    irVersion.reset(new std::atomic<uint32_t>[numIR]);
+    for (irCnt=0; irCnt<numIR; irCnt++)
+        irVersion[irCnt].store(0);
+    precision = filterBank ? filterBank->getPrecision() : FilterBank::PRECISION_FLOAT64;
+    if (precision == FilterBank::PRECISION_FLOAT32)
+        macKernel = &TVOLAP::macFloat32;
+    else if (precision == FilterBank::PRECISION_BFLOAT16)
+        macKernel = &TVOLAP::macBFloat16;
+    else if (precision == FilterBank::PRECISION_INT16)
+        macKernel = &TVOLAP::macInt16;
+    else
+        macKernel = &TVOLAP::macFloat64;
+    if (filterBank)
+    {
+        for (irCnt=0; irCnt<numIR; irCnt++)
+        {
+            irParts.at(irCnt) = filterBank->getParts(irCnt);
+            irReduced.at(irCnt) = filterBank->getReducedParts(irCnt);
+        }
+    }
 
-				for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
-					tmpPartIR.at(sampleCnt) = tmpIR.at(irCnt).at(chanCnt).at(partCnt*processLen+sampleCnt);
+    // prepare the twiddle table of fft.cpp for this FFT size, a larger table replaces it without freeing
+    // the old one, so instances with other block lengths keep transforming
+    if (table_get_nfft() < int(nfft/2))
+        set_twiddle_table(int(nfft));
+
+    stagedIdx = loadLenIR = loadPartsPerBlock = 0;
+    loadPartCnt.store(0);
+    stageState.store(STAGE_IDLE);
+
+    events.reset(new EventQueue);
+    events->numEvents.store(0);
+    events->numRejected.store(0);
+    events->sumSqLatency.store(0);
+    events->sumLatency.store(0);
+    events->minLatency.store(0);
+    events->maxLatency.store(0);
+    inSampleCnt.store(0);
+    initFades();
+    dirHysteresis = 0.0;
+    numBlendSteps = 0;
+    motionAzStep.store(0.0);
+    motionElStep.store(0.0);
+    hasMotion.store(false);
+}
 
-				rfft_double(tmpPartIR.data(), filterSpectrum.at(irCnt).at(chanCnt).at(partCnt).data(), nfft);
-			}
-		}
-	}
+TVOLAP::~TVOLAP()
+{
+    setAsync(false);
+    stopPipeline();
+    stopPrefetch();
 }
 
 void TVOLAP::process(double *inBlockInterleaved)
 {
-    uint32_t chanCntAudio, iChanPosAudio, chanCntIR, partCnt, sampleCnt;
-    int32_t freqReadCnt;
+    uint32_t chanCnt;
 
-    for (chanCntAudio=0, chanCntIR=0; chanCntAudio<numChansAudio && chanCntIR<numChansIR; chanCntAudio++, chanCntIR++)
+    for (chanCnt=0; chanCnt<numChansAudio; chanCnt++)
     {
-        for (sampleCnt=0, iChanPosAudio=chanCntAudio; sampleCnt<blockLen; sampleCnt++, iChanPosAudio+=numChansAudio)
-        {
-            inBlock[chanCntAudio][sampleCnt] = inBlock[chanCntAudio][sampleCnt+blockLen];
-            inBlock[chanCntAudio][sampleCnt+blockLen] = inBlockInterleaved[iChanPosAudio];
-        }
+        ioIn[chanCnt] = inBlockInterleaved+chanCnt;
+        ioOut[chanCnt] = inBlockInterleaved+chanCnt;
+    }
+    ioStride = numChansAudio;
+    ioFloat = false;
 
-        for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
-            inBlockWin[sampleCnt] = inBlock[chanCntAudio][sampleCnt]*winVec[sampleCnt];
+    processBlock();
+}
 
-        rfft_double(inBlockWin.data(), inSpectrum[chanCntAudio][freqSaveCnt].data(), nfft);
+void TVOLAP::process(const float * const *in, float * const *out)
+{
+    uint32_t chanCnt;
 
-        for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
-            inSpectrumSum[sampleCnt].re = inSpectrumSum[sampleCnt].im = 0.0;
+    for (chanCnt=0; chanCnt<numChansAudio; chanCnt++)
+    {
+        ioIn[chanCnt] = in[chanCnt];
+        ioOut[chanCnt] = out[chanCnt];
 
-        freqReadCnt = freqSaveCnt;
-        for (partCnt=0; partCnt<numParts; partCnt++)
-        {
-            for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
-            {
-                inSpectrumSum[sampleCnt] = complex_add(inSpectrumSum[sampleCnt],
-                        complex_mul(inSpectrum[chanCntAudio][freqReadCnt][sampleCnt], filterSpectrum[actIR][chanCntAudio][partCnt][sampleCnt]));
-            }
-
-            freqReadCnt-=overlapFact;
-            if (freqReadCnt<0)
-                freqReadCnt+=numMems;
-        }
+        // audio channels without an IR channel are passed through
+        if (chanCnt >= numChansIR && out[chanCnt] != in[chanCnt])
+            std::copy(in[chanCnt], in[chanCnt]+blockLen, out[chanCnt]);
+    }
+    ioStride = 1;
+    ioFloat = true;
 
-        irfft_double(inSpectrumSum.data(), ifftBlock.data(), nfft);
+    processBlock();
+}
 
-        for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
-        {
-            outBlock[chanCntAudio][sampleCnt] = ifftBlock[sampleCnt]+convMem[chanCntAudio][convSaveCnt][sampleCnt];
-            convMem[chanCntAudio][convSaveCnt][sampleCnt] = ifftBlock[sampleCnt+processLen];
-        }
+void TVOLAP::process(const double * const *in, double * const *out)
+{
+    uint32_t chanCnt;
 
-        for (sampleCnt=0, iChanPosAudio=chanCntAudio; sampleCnt<blockLen; sampleCnt++, iChanPosAudio+=numChansAudio)
-        {
-            inBlockInterleaved[iChanPosAudio] = outBlock[chanCntAudio][sampleCnt]+outBlockMem[chanCntAudio][sampleCnt];
-            outBlockMem[chanCntAudio][sampleCnt] = outBlock[chanCntAudio][sampleCnt+blockLen];
-        }
+    for (chanCnt=0; chanCnt<numChansAudio; chanCnt++)
+    {
+        ioIn[chanCnt] = in[chanCnt];
+        ioOut[chanCnt] = out[chanCnt];
+
+        if (chanCnt >= numChansIR && out[chanCnt] != in[chanCnt])
+            std::copy(in[chanCnt], in[chanCnt]+blockLen, out[chanCnt]);
+    }
+    ioStride = 1;
+    ioFloat = false;
+
+    processBlock();
+}
+
+void TVOLAP::processBlock()
+{
+    uint32_t chanCnt, numProcChans = std::min(numChansAudio, numChansIR);
+
+    applyEvents();
+    touchBlends();
+
+    // in pipeline mode the MAC thread reads the spectra, swaps staged IRs and fills the cache itself
+    if (parallelMode == PARALLEL_PIPELINE)
+    {
+        processPipeline();
+        return;
+    }
+
+    // the IR selection is latched for the whole block
+    std::copy(chanIR.begin(), chanIR.end(), procIR.begin());
+
+    holdFadingIRs();
+    applyStagedIR();
+    acquireChannelIRs(procIR);
+    startFades();
+
+    if (parallelMode == PARALLEL_CHANNELS)
+    {
+        threadPool->run(&TVOLAP::channelJob, this, numProcChans);
+    }
+    else
+    {
+        for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+            processChannel(chanCnt, 0);
     }
 
     freqSaveCnt++;
@@ -194,6 +334,270 @@ void TVOLAP::process(double *inBlockInterleaved)
 		convSaveCnt=0;
 }
 
+void TVOLAP::readInput(uint32_t chanCnt)
+{
+    double *block = inBlock[chanCnt].data();
+    uint32_t sampleCnt, iChanPosAudio;
+
+    // the process window slides by one block, the new block is converted straight into it
+    std::copy(block+blockLen, block+processLen, block);
+
+    if (ioFloat)
+    {
+        const float *in = (const float *) ioIn[chanCnt];
+
+        for (sampleCnt=0; sampleCnt<blockLen; sampleCnt++)
+            block[sampleCnt+blockLen] = in[sampleCnt];
+    }
+    else
+    {
+        const double *in = (const double *) ioIn[chanCnt];
+
+        for (sampleCnt=0, iChanPosAudio=0; sampleCnt<blockLen; sampleCnt++, iChanPosAudio+=ioStride)
+            block[sampleCnt+blockLen] = in[iChanPosAudio];
+    }
+}
+
+void TVOLAP::writeOutput(uint32_t chanCnt, const double *samples)
+{
+    uint32_t sampleCnt, iChanPosAudio;
+
+    // samples = NULL writes silence
+    if (ioFloat)
+    {
+        float *out = (float *) ioOut[chanCnt];
+
+        if (samples == NULL)
+            std::fill(out, out+blockLen, 0.0f);
+        else
+        {
+            for (sampleCnt=0; sampleCnt<blockLen; sampleCnt++)
+                out[sampleCnt] = float(samples[sampleCnt]);
+        }
+    }
+    else
+    {
+        double *out = (double *) ioOut[chanCnt];
+
+        for (sampleCnt=0, iChanPosAudio=0; sampleCnt<blockLen; sampleCnt++, iChanPosAudio+=ioStride)
+            out[iChanPosAudio] = samples == NULL ? 0.0 : samples[sampleCnt];
+    }
+}
+
+void TVOLAP::processChannel(uint32_t chanCnt, uint32_t threadIdx)
+{
+    uint32_t taskCnt, sampleCnt;
+    std::vector<double> &inBlockWin = this->inBlockWin[threadIdx];
+    std::vector<double> &ifftBlock = this->ifftBlock[threadIdx];
+    std::vector<complex_float64> &inSpectrumSum = this->inSpectrumSum[threadIdx];
+
+    readInput(chanCnt);
+
+    for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+        inBlockWin[sampleCnt] = inBlock[chanCnt][sampleCnt]*winVec[sampleCnt];
+
+    rfft_double(inBlockWin.data(), inSpectrum[chanCnt][freqSaveCnt].data(), nfft);
+
+    if (events->fades[chanCnt].restart)
+        beginFade(chanCnt, threadIdx);
+
+    if (parallelMode == PARALLEL_PARTITIONS && numPartTasks > 1)
+    {
+        jobChan = chanCnt;
+        threadPool->run(&TVOLAP::partitionJob, this, numPartTasks);
+
+        for (taskCnt=1; taskCnt<numPartTasks; taskCnt++)
+        {
+            for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
+                inSpectrumSum[sampleCnt] = complex_add(inSpectrumSum[sampleCnt], this->inSpectrumSum[taskCnt][sampleCnt]);
+        }
+    }
+    else
+        macPartitions(chanCnt, 0, numParts, inSpectrumSum.data());
+
+    irfft_double(inSpectrumSum.data(), ifftBlock.data(), nfft);
+
+    for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+    {
+        outBlock[chanCnt][sampleCnt] = ifftBlock[sampleCnt]+convMem[chanCnt][convSaveCnt][sampleCnt];
+        convMem[chanCnt][convSaveCnt][sampleCnt] = ifftBlock[sampleCnt+processLen];
+    }
+
+    for (sampleCnt=0; sampleCnt<blockLen; sampleCnt++)
+    {
+        outBlock[chanCnt][sampleCnt] += outBlockMem[chanCnt][sampleCnt];
+        outBlockMem[chanCnt][sampleCnt] = outBlock[chanCnt][sampleCnt+blockLen];
+    }
+
+    if (events->fades[chanCnt].active)
+        mixFade(chanCnt, threadIdx);
+
+    writeOutput(chanCnt, outBlock[chanCnt].data());
+}
+
+void TVOLAP::macPartitions(uint32_t chanCnt, uint32_t partBeg, uint32_t partEnd, complex_float64 *spectrumSum)
+{
+    uint32_t partCnt, sampleCnt, partOffset = partOffsets[procIR[chanCnt]*numChansIR+chanCnt];
+    int32_t freqReadCnt;
+
+    for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
+        spectrumSum[sampleCnt].re = spectrumSum[sampleCnt].im = 0.0;
+
+    freqReadCnt = int32_t(freqSaveCnt)-int32_t(((partBeg+partOffset)*overlapFact)%numMems);
+    if (freqReadCnt<0)
+        freqReadCnt+=numMems;
+
+    // the kernel and the partitions of the IR are looked up once, not per partition
+    MacKernel mac = macKernel;
+    const void * const *parts = filterParts(procIR[chanCnt])+chanCnt*numParts;
+
+    for (partCnt=partBeg; partCnt<partEnd; partCnt++)
+    {
+        mac(spectrumSum, inSpectrum[chanCnt][freqReadCnt].data(), parts[partCnt], processLen+1);
+
+        freqReadCnt-=overlapFact;
+        if (freqReadCnt<0)
+            freqReadCnt+=numMems;
+    }
+}
+
+void TVOLAP::channelJob(void *context, uint32_t taskIdx, uint32_t threadIdx)
+{
+    TVOLAP *inst = (TVOLAP *) context;
+
+    inst->processChannel(taskIdx, threadIdx);
+}
+
+void TVOLAP::partitionJob(void *context, uint32_t taskIdx, uint32_t)
+{
+    TVOLAP *inst = (TVOLAP *) context;
+    uint32_t partBeg = taskIdx*inst->numParts/inst->numPartTasks;
+    uint32_t partEnd = (taskIdx+1)*inst->numParts/inst->numPartTasks;
+
+    // every task owns one partial sum, so the reduction order is deterministic
+    inst->macPartitions(inst->jobChan, partBeg, partEnd, inst->inSpectrumSum[taskIdx].data());
+}
+
+int TVOLAP::setParallelMode(ParallelMode parallelMode, uint32_t numThreads, int firstCpu)
+{
+    if (parallelMode != PARALLEL_OFF && parallelMode != PARALLEL_PARTITIONS &&
+        parallelMode != PARALLEL_CHANNELS && parallelMode != PARALLEL_PIPELINE)
+        return -1;
+
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    // the pipeline keeps its own frequency delay line, so entering or leaving it restarts from silence
+    if (this->parallelMode == PARALLEL_PIPELINE || parallelMode == PARALLEL_PIPELINE)
+    {
+        stopPipeline();
+        clearState();
+    }
+
+    threadPool.reset();
+    this->parallelMode = PARALLEL_OFF;
+    this->numPartTasks = 1;
+    resizeScratch(1);
+
+    if (parallelMode == PARALLEL_PIPELINE)
+    {
+        startPipeline(firstCpu);
+        this->parallelMode = parallelMode;
+        return 0;
+    }
+
+    if (parallelMode == PARALLEL_PARTITIONS)
+    {
+        numThreads = std::min(numThreads, numParts);
+        numPartTasks = numThreads;
+    }
+    else if (parallelMode == PARALLEL_CHANNELS)
+        numThreads = std::min(numThreads, std::min(numChansAudio, numChansIR));
+
+    if (parallelMode == PARALLEL_OFF || numThreads < 2)
+    {
+        numPartTasks = 1;
+        return 0;
+    }
+
+    resizeScratch(numThreads);
+    threadPool.reset(new ThreadPool(numThreads, firstCpu));
+    this->parallelMode = parallelMode;
+
+    return 0;
+}
+
+uint32_t TVOLAP::getLatency() const
+{
+    return parallelMode == PARALLEL_PIPELINE ? PIPELINE_DELAY*blockLen : 0;
+}
+
+uint32_t TVOLAP::getBlockLen() const
+{
+    return blockLen;
+}
+
+uint32_t TVOLAP::getMaxLenIR() const
+{
+    return numParts*processLen;
+}
+
+void TVOLAP::clearState()
+{
+    uint32_t chanCnt, convCnt, memCnt;
+
+    for (chanCnt=0; chanCnt<numChansAudio; chanCnt++)
+    {
+        std::fill(inBlock.at(chanCnt).begin(), inBlock.at(chanCnt).end(), 0.0);
+        std::fill(outBlock.at(chanCnt).begin(), outBlock.at(chanCnt).end(), 0.0);
+        std::fill(outBlockMem.at(chanCnt).begin(), outBlockMem.at(chanCnt).end(), 0.0);
+        for (convCnt=0; convCnt<overlapFact; convCnt++)
+            std::fill(convMem.at(chanCnt).at(convCnt).begin(), convMem.at(chanCnt).at(convCnt).end(), 0.0);
+    }
+
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+    {
+        for (memCnt=0; memCnt<numMems; memCnt++)
+            std::fill(inSpectrum.at(chanCnt).at(memCnt).begin(), inSpectrum.at(chanCnt).at(memCnt).end(), complex(0.0, 0.0));
+    }
+
+    // the pipeline does not track the IRs of the crossfades
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+    {
+        events->fades.at(chanCnt).lastIR = chanIR.at(chanCnt);
+        events->fades.at(chanCnt).requested = events->fades.at(chanCnt).active = events->fades.at(chanCnt).restart = false;
+    }
+
+    freqSaveCnt = 0;
+    convSaveCnt = 0;
+}
+
+void TVOLAP::allocSpectra(IRSpectra &spectra, uint32_t numIRs)
+{
+    uint32_t partCnt;
+
+    spectra.bins.resize(numIRs*numChansIR*numParts*(processLen+1));
+    spectra.parts.resize(numIRs*numChansIR*numParts);
+    for (partCnt=0; partCnt<numIRs*numChansIR*numParts; partCnt++)
+        spectra.parts.at(partCnt) = &spectra.bins.at(partCnt*(processLen+1));
+}
+
+void TVOLAP::resizeScratch(uint32_t numThreads)
+{
+    uint32_t threadCnt;
+
+    // one set of scratch buffers per thread, in partition mode the partial sums of the tasks
+    inBlockWin.resize(numThreads);
+    ifftBlock.resize(numThreads);
+    inSpectrumSum.resize(numThreads);
+    for (threadCnt=0; threadCnt<numThreads; threadCnt++)
+    {
+        inBlockWin.at(threadCnt).resize(nfft, 0.0);
+        ifftBlock.at(threadCnt).resize(nfft, 0.0);
+        inSpectrumSum.at(threadCnt).resize(processLen+1);
+    }
+}
+
 /*------------------------------License---------------------------------------*\
 | Copyright (c) 2012-2017 Hagen Jaeger, Uwe Simmer                             |
 |                                                                              |
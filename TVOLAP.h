@@ -9,37 +9,383 @@
 #define TVOLAP_H
 
 #include <stdint.h>
+#include <algorithm>
+#include <atomic>
 #include <vector>
+#include <memory>
 #include "fft.h"
+#include "FilterBank.h"
+#include "DirectionIndex.h"
 #include "complex_functions.h"
 
+class ThreadPool;
+class BasisBank;
+class MinPhaseBank;
+
 class TVOLAP
 {
 
 public:
+    enum ParallelMode
+    {
+        PARALLEL_OFF = 0,
+        PARALLEL_PARTITIONS = 1,
+        PARALLEL_CHANNELS = 2,
+        PARALLEL_PIPELINE = 3
+    };
+
+    // IR cache: a missing IR is transformed by the block that uses it or deferred to the prefetch thread
+    enum MissMode
+    {
+        MISS_TRANSFORM = 0,
+        MISS_DEFER = 1
+    };
+
+    struct CacheStats
+    {
+        uint64_t numHits, numMisses, numEvictions, numPrefetches, numFailures, residentBytes, maxResidentBytes;
+    };
+
+    // latencies in samples from the time stamp of an event to the center of its crossfade
+    struct EventStats
+    {
+        uint64_t numEvents, numRejected;
+        int64_t minLatency, maxLatency;
+        double meanLatency, jitter;
+    };
+
+    typedef FilterBank::IRProvider IRProvider;
+
+    // the filter spectra are transformed on numBuildThreads threads (0 = all cores), the result
+    // does not depend on the number of threads
     TVOLAP(std::vector<double> &interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
-          uint32_t blockLen, uint32_t numChansAudio);
+          uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads = 1);
+
+    // the partitions are transformed directly from caller owned data (numIR*numChansIR*lenIR samples
+    // in the layout of interleavedIR) or from a provider, no copy of the IR bank is made
+    TVOLAP(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+          uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads = 1);
+    TVOLAP(IRProvider provider, void *context, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+          uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads = 1);
+
+    // minimum phase bank (see MinPhaseBank.h): the delay of an IR channel is realized in whole partitions
+    // by the frequency delay line and the rest within the filter, so an IR switch cross fades the delay as
+    // well. stageIR() and loadIR() replace the filter behind the delay of an IR.
+    TVOLAP(const MinPhaseBank &minPhaseBank, uint32_t blockLen, uint32_t numChansAudio, uint32_t numBuildThreads = 1);
+
+    // instance on a filter bank that is shared with other instances, only the processing state is private
+    TVOLAP(std::shared_ptr<const FilterBank> filterBank, uint32_t numChansAudio);
+
+    // IR bank as raw float64 file in the layout of interleavedIR (e.g. Kemar_TUBerlin_*.bin files
+    // concatenated), memory mapped and transformed on demand into an LRU cache of at most
+    // maxCacheBytes filter spectra (at least one IR per processed channel)
+    TVOLAP(const char *irBankFile, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+          uint32_t blockLen, uint32_t numChansAudio, uint64_t maxCacheBytes);
+
+    // lazy construction: only the source (kept by the caller) is recorded, the spectra of an IR are
+    // transformed into an IR cache of at most maxCacheBytes when it is used first, see setMissMode().
+    // Without a limit the memory grows with the IRs in use and nothing is evicted.
+    TVOLAP(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+          uint32_t blockLen, uint32_t numChansAudio, MissMode missMode, uint64_t maxCacheBytes = UINT64_MAX);
+    TVOLAP(IRProvider provider, void *context, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+          uint32_t blockLen, uint32_t numChansAudio, MissMode missMode, uint64_t maxCacheBytes = UINT64_MAX);
+
+    // low rank bank (see BasisBank.h), the spectra of an IR are reconstructed from the basis into an
+    // IR cache when it is used first, so the MAC per block stays at one filter per channel. maxCacheBytes = 0
+    // holds numBasis+1 IRs (at least one per channel), UINT64_MAX lets the cache grow to the whole bank
+    TVOLAP(std::shared_ptr<const BasisBank> basisBank, uint32_t numChansAudio, MissMode missMode = MISS_TRANSFORM,
+          uint64_t maxCacheBytes = 0);
+
+    // precomputed filter spectra written by saveFilterSpectra() (see makeSpectraFile), mapped and
+    // used without copy, throws if the file was generated for another block length
+    TVOLAP(const char *spectraFile, uint32_t blockLen, uint32_t numChansAudio);
+    ~TVOLAP();
 
     void process(double *inBlockInterleaved);
 
+    // planar blocks of blockLen samples per audio channel (e.g. JACK buffers), read and written
+    // without an interleaved copy. out[c] may be in[c], audio channels without an IR channel are copied
+    void process(const float * const *in, float * const *out);
+    void process(const double * const *in, double * const *out);
+
+    // must not be called concurrently to process(), numThreads = 0 uses all cores,
+    // firstCpu >= 0 pins worker n to cpu firstCpu+n
+    int setParallelMode(ParallelMode parallelMode, uint32_t numThreads, int firstCpu = -1);
+
+    // additional delay of the output in samples caused by the parallel mode
+    uint32_t getLatency() const;
+
+    uint32_t getBlockLen() const;
+    // longest IR in samples per channel that fits the partitions of the instance
+    uint32_t getMaxLenIR() const;
+
+    // asynchronous processing: submit() hands a block to an internal worker, collect() returns the
+    // oldest processed block (0), 1 if it is not ready yet and -1 if nothing was submitted. submit()
+    // returns -1 if both buffers are in use. process() must not be called while async is enabled.
+    int setAsync(bool enable, int cpuIdx = -1);
+    int submit(const double *inBlockInterleaved);
+    int collect(double *outBlockInterleaved);
+
+    // renders a whole signal on numThreads cores (0 = all) as if processed block by block from silence,
+    // irSchedule holds the IR index of every block, in and out must be different buffers and the
+    // real time state is not touched. With an IR cache the scheduled IRs are transformed into private
+    // slots, as many as the cache has, only failures of the provider are counted in the CacheStats.
+    int processOffline(const double *inInterleaved, double *outInterleaved, uint32_t numFrames,
+            const std::vector<uint32_t> &irSchedule, uint32_t numThreads = 0);
+
+    // replaces IR irIdx at runtime without losing the overlap state: stageIR() partitions and
+    // transforms irSamples (numChansIR channels one after another, each at most numParts*2*blockLen
+    // long) off the audio thread, publishIR() lets process() swap the spectra in at the next block
+    // boundary (windowed switch). The replaced spectra are freed by the next stageIR() or reclaimIR().
+    // Not available with a filter bank in reduced precision.
+    int stageIR(uint32_t irIdx, const std::vector<double> &irSamples);
+    // stages several IRs at once that are swapped in at the same block boundary: IR irIdx[k] is
+    // replaced by IR k of bank (float64, same blockLen, numChansIR and getMaxLenIR()). The spectra
+    // are only referenced, so one bank can be staged into many instances.
+    int stageIRs(const std::vector<uint32_t> &irIdx, std::shared_ptr<const FilterBank> bank);
+    int publishIR();
+    int reclaimIR();
+
+    // for targets without a spare thread: process() transforms numPartsPerBlock partitions of the
+    // staged IR per call and swaps it in when all are done, getLoadProgress() returns 0...1
+    int loadIR(uint32_t irIdx, const std::vector<double> &irSamples, uint32_t numPartsPerBlock);
+    double getLoadProgress() const;
+
+    // must not be called concurrently to process(), returns -1 if the file cannot be written or the
+    // instance delays IRs by whole partitions (minimum phase bank). The IR cache is left as it is.
+    int saveFilterSpectra(const char *fileName);
+
+    // hits and misses are counted per channel and block, returns -1 without IR cache
+    int getCacheStats(CacheStats &stats) const;
+
+    // IR cache only, must not be called concurrently to process(): with MISS_DEFER a channel keeps the
+    // IR of its last block until the prefetch thread has transformed the new one, so process() never
+    // transforms (started without prediction if setPrefetch() was not called)
+    int setMissMode(MissMode missMode);
+
+    // IR cache only: 0 and the index of an IR that process() used for the first time, 1 if there is
+    // none. Every IR is reported once, for one polling thread.
+    int pollFirstUse(uint32_t &irIdx);
+
+    // transforms predicted IRs into the IR cache on a background thread (IR cache only, 0 disables):
+    // numAhead IRs per channel and block are predicted from the last IR change of the channel or, after
+    // setMotion(), from the position of its IR. Needs numAhead additional IR spectra, must not be called
+    // concurrently to process().
+    int setPrefetch(uint32_t numAhead, int cpuIdx = -1);
+
+    // change of the source directions in degrees per block (e.g. against the head rotation) for the
+    // prediction, needs setPositions(), may be called from one other thread
+    int setMotion(double azimuthStep, double elevationStep);
+
+    // thread safe IR selection for one other thread: from input sample sampleIdx on (counted since
+    // construction, see getSampleCnt()) the IR channels firstChan...firstChan+numChans-1 use actIR.
+    // The change is crossfaded over IR_EVENT_FADE_LEN samples from sampleIdx on, an event during the
+    // crossfade of its channel waits for the next block after it (block switching in pipeline mode).
+    // Events must be queued in ascending time, returns -1 if the queue is full or an argument is invalid.
+    int queueIR(uint64_t sampleIdx, uint32_t firstChan, uint32_t numChans, uint32_t actIR);
+    uint64_t getSampleCnt() const;
+
+    // jitter is the standard deviation of the latency
+    int getEventStats(EventStats &stats) const;
+
+    // cache of numSlots blended IRs for setIRBlend() (0 disables it), with the weights quantized to numSteps
+    // steps. Not available with an IR cache or a filter bank in reduced precision, must be called before the
+    // pipeline or async mode is enabled.
+    int setBlendCache(uint32_t numSlots, uint32_t numSteps = 64);
+
+    // weighted sum (1-alpha)*irA + alpha*irB of two IRs as if it were an IR of the bank, for all IR channels
+    // or a channel group. Must be called by the thread that calls process(), a new blend is computed at once.
+    // Returns -1 in async mode and if every slot is selected by other channels or (pipeline) used by a block in flight.
+    int setIRBlend(uint32_t irA, uint32_t irB, double alpha);
+    int setIRBlend(uint32_t firstChan, uint32_t numChans, uint32_t irA, uint32_t irB, double alpha);
+
+    // optional source positions of the IRs (see DirectionIndex.h) for the direction based IR selection,
+    // a new IR is only taken if it is closer to the direction than the actual one by more than hysteresis
+    // degrees. Must not be called concurrently to findIR() or setDirection().
+    int setPositions(const std::vector<double> &azimuth, const std::vector<double> &elevation,
+            const std::vector<double> &distance = std::vector<double>(), double hysteresis = 0.0);
+
+    // IR nearest to a direction (e.g. for queueIR() on a head tracker thread), prevIR < numIR enables the
+    // hysteresis, returns -1 without positions
+    int findIR(double azimuth, double elevation, double distance = 0.0, uint32_t prevIR = 0xFFFFFFFFu) const;
+
+    // setIR() of the IR nearest to the direction for all IR channels or a channel group, returns the IR
+    int setDirection(double azimuth, double elevation, double distance = 0.0);
+    int setDirection(uint32_t firstChan, uint32_t numChans, double azimuth, double elevation, double distance = 0.0);
+
+    // the setIR() and setDirection() functions must be called by the thread that calls process(), other threads use queueIR()
     inline int setIR(uint32_t actIR)
     {
     	if (actIR >= numIR)
 			return -1;
     	else
-    		this->actIR = actIR;
+    		std::fill(chanIR.begin(), chanIR.end(), actIR);
 
     	return 0;
     }
 
+    // IR of one IR channel or of a group of numChans consecutive IR channels (e.g. both ears of a
+    // source), so independently moving sources can share one instance
+    inline int setIR(uint32_t chanIdx, uint32_t actIR)
+    {
+        return setIR(chanIdx, 1, actIR);
+    }
+
+    inline int setIR(uint32_t firstChan, uint32_t numChans, uint32_t actIR)
+    {
+        if (actIR >= numIR || firstChan >= numChansIR || numChans > numChansIR-firstChan)
+            return -1;
+        else
+            std::fill(chanIR.begin()+firstChan, chanIR.begin()+firstChan+numChans, actIR);
+
+        return 0;
+    }
+
 private:
-    uint32_t blockLen, processLen, nfft, numIR, actIR, numChansAudio, numChansIR, numParts, numMems, overlapFact, freqSaveCnt, convSaveCnt;
-    std::vector<double> winVec, inBlockWin, ifftBlock;
-    std::vector<complex_float64> inSpectrumSum;
-    std::vector< std::vector<double> > inBlock, outBlock, outBlockMem;
+    struct Pipeline;
+    struct Offline;
+    struct Async;
+    struct IRCache;
+    struct Prefetch;
+    struct IREvent;
+    struct EventQueue;
+    struct EventFade;
+
+    // transfer functions of the partitions, parts[(irCnt*numChansIR+chanCnt)*numParts+partCnt]
+    struct IRSpectra
+    {
+        std::vector<complex_float64> bins;
+        std::vector<const complex_float64 *> parts;
+    };
+
+    enum StageState
+    {
+        STAGE_IDLE = 0,
+        STAGE_STAGED = 1,
+        STAGE_PUBLISHED = 2,
+        STAGE_SWAPPED = 3,
+        STAGE_LOADING = 4
+    };
+
+    static inline void macSpectrum(complex_float64 *spectrumSum, const complex_float64 *inSpectrum,
+            const complex_float64 *filterSpectrum, uint32_t numBins)
+    {
+        for (uint32_t sampleCnt=0; sampleCnt<numBins; sampleCnt++)
+            spectrumSum[sampleCnt] = complex_add(spectrumSum[sampleCnt], complex_mul(inSpectrum[sampleCnt], filterSpectrum[sampleCnt]));
+    }
+
+    // multiply accumulate of one filter partition into double, one kernel per precision of the filter bank
+    typedef void (*MacKernel)(complex_float64 *spectrumSum, const complex_float64 *inSpectrum,
+            const void *filterSpectrum, uint32_t numBins);
+
+    // partitions of an IR in the precision of the filter bank, for macKernel
+    inline const void * const *filterParts(uint32_t irIdx) const
+    {
+        if (precision == FilterBank::PRECISION_FLOAT64)
+            return (const void * const *) irParts[irIdx];
+        else
+            return irReduced[irIdx];
+    }
+
+    static void macFloat64(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins);
+    static void macFloat32(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins);
+    static void macBFloat16(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins);
+    static void macInt16(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins);
+    void init(uint32_t numIR, uint32_t lenIR, uint32_t numChansIR, uint32_t blockLen, uint32_t numChansAudio);
+    void clearState();
+    void allocSpectra(IRSpectra &spectra, uint32_t numIRs);
+    void applyStagedIR();
+    void applyEvents();
+    void initFades();
+    void holdFadingIRs();
+    void startFades();
+    bool fadesFromIR(uint32_t chanCnt, uint32_t irIdx) const;
+    void macDelayed(uint32_t chanCnt, uint32_t irIdx, uint32_t delay, complex_float64 *spectrumSum);
+    void beginFade(uint32_t chanCnt, uint32_t threadIdx);
+    void mixFade(uint32_t chanCnt, uint32_t threadIdx);
+    void touchBlends();
+    bool loadPartitions();
+    uint32_t nextUseStamp();
+    bool acquireIR(uint32_t irIdx, uint32_t useStamp);
+    uint32_t evictCacheSlot(uint32_t useStamp);
+    void acquireChannelIRs(std::vector<uint32_t> &procIR);
+    void initCache(uint32_t lenIR, uint64_t maxCacheBytes);
+    void allocCacheSlot(uint32_t slotIdx);
+    void requestIR(uint32_t irIdx);
+    void transformBankIR(uint32_t irIdx, complex_float64 *bins, std::vector<double> &tmpPartIR) const;
+    void adoptPrefetched();
+    void requestPrefetch(const std::vector<uint32_t> &procIR);
+    void prefetchLoop(int cpuIdx);
+    void stopPrefetch();
+    void processBlock();
+    void readInput(uint32_t chanCnt);
+    void writeOutput(uint32_t chanCnt, const double *samples);
+    void processChannel(uint32_t chanCnt, uint32_t threadIdx);
+    void macPartitions(uint32_t chanCnt, uint32_t partBeg, uint32_t partEnd, complex_float64 *spectrumSum);
+    void resizeScratch(uint32_t numThreads);
+    static void channelJob(void *context, uint32_t taskIdx, uint32_t threadIdx);
+    static void partitionJob(void *context, uint32_t taskIdx, uint32_t threadIdx);
+    void startPipeline(int firstCpu);
+    void stopPipeline();
+    void processPipeline();
+    void pipelineMacLoop(int cpuIdx);
+    void pipelineIfftLoop(int cpuIdx);
+    void asyncLoop(int cpuIdx);
+
+    uint32_t blockLen, processLen, nfft, numIR, numChansAudio, numChansIR, numParts, numMems, overlapFact, freqSaveCnt, convSaveCnt;
+    std::vector<double> winVec;
+    std::vector<uint32_t> chanIR, procIR;
+    // delay of the IR channels in partitions, partOffsets[irCnt*numChansIR+chanCnt]
+    std::vector<uint32_t> partOffsets;
+    uint32_t maxPartOffset;
+    ParallelMode parallelMode;
+    uint32_t numPartTasks, jobChan;
+    // sample n of audio channel c in the block of the actual process() call is ioIn[c][n*ioStride],
+    // ioFloat selects float instead of double samples
+    std::vector<const void *> ioIn;
+    std::vector<void *> ioOut;
+    uint32_t ioStride;
+    bool ioFloat;
+    std::unique_ptr<ThreadPool> threadPool;
+    std::unique_ptr<Pipeline> pipeline;
+    std::unique_ptr<Async> async;
+    std::unique_ptr<IRCache> irCache;
+    std::unique_ptr<Prefetch> prefetch;
+    std::vector< std::unique_ptr<IRSpectra> > prefetchSpectra;
+    std::atomic<double> motionAzStep, motionElStep;
+    std::atomic<bool> hasMotion;
+    std::unique_ptr<EventQueue> events;
+    std::atomic<uint64_t> inSampleCnt;
+    // blended IRs, selected as numIR+slot
+    std::vector< std::unique_ptr<IRSpectra> > blendSpectra;
+    std::vector<uint32_t> blendIRA, blendIRB, blendStep;
+    std::vector<uint64_t> blendUse;
+    std::vector<uint32_t> blendVersionA, blendVersionB;
+    uint32_t numBlendSteps;
+    DirectionIndex dirIndex;
+    double dirHysteresis;
+    std::vector< std::vector<complex_float64> > inSpectrumSum;
+    std::vector< std::vector<double> > inBlockWin, ifftBlock, inBlock, outBlock, outBlockMem;
     std::vector< std::vector< std::vector<double> > > convMem;
     std::vector< std::vector< std::vector<complex_float64> > > inSpectrum;
-    std::vector< std::vector< std::vector< std::vector<complex_float64> > > > filterSpectrum;
+    std::shared_ptr<const FilterBank> filterBank;
+    std::vector<const complex_float64 * const *> irParts;
+    FilterBank::Precision precision;
+    MacKernel macKernel;
+    std::vector<const void * const *> irReduced;
+    std::vector< std::unique_ptr<IRSpectra> > irLoaded;
+    std::vector< std::shared_ptr<const FilterBank> > irShared;
+    // counts the replacements of every IR, keys the blends of the IR
+    std::unique_ptr< std::atomic<uint32_t>[] > irVersion;
+    std::unique_ptr<IRSpectra> stagedIR;
+    std::shared_ptr<const FilterBank> stagedBank;
+    std::vector<uint32_t> stagedBatch;
+    std::vector< std::unique_ptr<IRSpectra> > retiredIRs;
+    std::vector< std::shared_ptr<const FilterBank> > retiredBanks;
+    uint32_t stagedIdx, loadLenIR, loadPartsPerBlock;
+    std::vector<double> loadSamples, loadPartIR;
+    std::atomic<uint32_t> loadPartCnt;
+    std::atomic<uint32_t> stageState;
 };
 
 #endif // TVOLAP_H
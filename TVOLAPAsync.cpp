@@ -0,0 +1,141 @@
+/*-----------------------------------------------------------------------------*\
+| Asynchronous processing of TVOLAP for hosts with lookahead. submit() copies  |
+| a block into one of two buffers, an internal worker runs process() on it in  |
+| place and collect() copies the result back. Three free running counters      |
+| (submitted, done, collected) hand the buffers between the threads, so the    |
+| real time thread only copies and never waits.                                |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include "TVOLAPAsync.h"
+#include "ThreadPool.h"
+
+#define ASYNC_SPIN_CNT_BEFORE_SLEEP 16384
+
+int TVOLAP::setAsync(bool enable, int cpuIdx)
+{
+    uint32_t bufCnt;
+
+    if (async)
+    {
+        async->quit.store(true, std::memory_order_seq_cst);
+        async->submitCnt.fetch_add(1, std::memory_order_seq_cst);
+        ThreadPool::futexWake(async->submitCnt);
+        async->worker.join();
+        async.reset();
+    }
+
+    if (!enable)
+        return 0;
+
+    async.reset(new Async);
+    for (bufCnt=0; bufCnt<ASYNC_NUM_BUFFERS; bufCnt++)
+        async->buffer[bufCnt].resize(blockLen*numChansAudio, 0.0);
+    async->submitCnt.store(0);
+    async->doneCnt.store(0);
+    async->collectCnt.store(0);
+    async->sleeping.store(0);
+    async->quit.store(false);
+    async->worker = std::thread(&TVOLAP::asyncLoop, this, cpuIdx);
+
+    return 0;
+}
+
+int TVOLAP::submit(const double *inBlockInterleaved)
+{
+    uint32_t submitCnt, sampleCnt;
+
+    if (!async)
+        return -1;
+
+    submitCnt = async->submitCnt.load(std::memory_order_relaxed);
+    // collect() must have finished copying the buffer before it is overwritten
+    if (submitCnt-async->collectCnt.load(std::memory_order_acquire) >= ASYNC_NUM_BUFFERS)
+        return -1;
+
+    std::vector<double> &buffer = async->buffer[submitCnt%ASYNC_NUM_BUFFERS];
+    for (sampleCnt=0; sampleCnt<blockLen*numChansAudio; sampleCnt++)
+        buffer[sampleCnt] = inBlockInterleaved[sampleCnt];
+
+    async->submitCnt.store(submitCnt+1, std::memory_order_seq_cst);
+    if (async->sleeping.load(std::memory_order_seq_cst) > 0)
+        ThreadPool::futexWake(async->submitCnt);
+
+    return 0;
+}
+
+int TVOLAP::collect(double *outBlockInterleaved)
+{
+    uint32_t collectCnt, sampleCnt;
+
+    if (!async)
+        return -1;
+
+    collectCnt = async->collectCnt.load(std::memory_order_relaxed);
+    if (collectCnt == async->submitCnt.load(std::memory_order_relaxed))
+        return -1;
+
+    // the worker is still busy with the oldest submitted block
+    if (collectCnt == async->doneCnt.load(std::memory_order_acquire))
+        return 1;
+
+    std::vector<double> &buffer = async->buffer[collectCnt%ASYNC_NUM_BUFFERS];
+    for (sampleCnt=0; sampleCnt<blockLen*numChansAudio; sampleCnt++)
+        outBlockInterleaved[sampleCnt] = buffer[sampleCnt];
+
+    async->collectCnt.store(collectCnt+1, std::memory_order_release);
+
+    return 0;
+}
+
+void TVOLAP::asyncLoop(int cpuIdx)
+{
+    Async &asy = *async;
+    uint32_t doneCnt = 0, submitCnt, spinCnt = 0;
+
+    if (cpuIdx >= 0)
+        ThreadPool::setThreadAffinity(uint32_t(cpuIdx));
+
+    while (true)
+    {
+        // quit is raised before the submit counter is bumped for the wake up
+        submitCnt = asy.submitCnt.load(std::memory_order_seq_cst);
+        if (asy.quit.load(std::memory_order_seq_cst))
+            break;
+
+        if (submitCnt == doneCnt)
+        {
+            if (++spinCnt >= ASYNC_SPIN_CNT_BEFORE_SLEEP)
+            {
+                asy.sleeping.fetch_add(1, std::memory_order_seq_cst);
+                ThreadPool::futexWait(asy.submitCnt, submitCnt);
+                asy.sleeping.fetch_sub(1, std::memory_order_seq_cst);
+                spinCnt = 0;
+            }
+            continue;
+        }
+
+        process(asy.buffer[doneCnt%ASYNC_NUM_BUFFERS].data());
+        asy.doneCnt.store(++doneCnt, std::memory_order_release);
+        spinCnt = 0;
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
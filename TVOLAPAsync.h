@@ -0,0 +1,44 @@
+/*-----------------------------------------------------------------------------*\
+| Private header of TVOLAPAsync.cpp, only included by the TVOLAP sources.       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef TVOLAPASYNC_H
+#define TVOLAPASYNC_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "TVOLAP.h"
+
+#define ASYNC_NUM_BUFFERS 2
+
+struct TVOLAP::Async
+{
+    std::vector<double> buffer[ASYNC_NUM_BUFFERS];
+    std::atomic<uint32_t> submitCnt, doneCnt, collectCnt, sleeping;
+    std::atomic<bool> quit;
+    std::thread worker;
+};
+
+#endif // TVOLAPASYNC_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
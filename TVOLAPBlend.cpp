@@ -0,0 +1,182 @@
+/*-----------------------------------------------------------------------------*\
+| Fractional IR selection. setIRBlend() selects the weighted sum of two IRs,    |
+| with the weight quantized to numSteps steps. Since the transform is linear,   |
+| the blended filter spectra are the same weighted sum of the partition spectra |
+| of both IRs. They are computed when a blend is selected first and kept in an  |
+| LRU cache of a few blended IRs, so repeated positions cost nothing and the    |
+| MAC stays at a single filter per channel. The cached blends are addressed     |
+| like IRs behind the bank (numIR + slot), so all processing modes use them     |
+| unchanged. A slot is only overwritten when no other channel selects it and,   |
+| with the pipeline, when no block in flight may read it.                       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "TVOLAP.h"
+#include "TVOLAPPipeline.h"
+
+#define BLEND_GUARD_BLOCKS (PIPELINE_DELAY+2)
+
+int TVOLAP::setBlendCache(uint32_t numSlots, uint32_t numSteps)
+{
+    uint32_t chanCnt, slotCnt;
+
+    // the MAC thread of the pipeline and the async worker read the partition table at any time
+    if (irCache || pipeline || async || precision != FilterBank::PRECISION_FLOAT64 || numSteps < 2)
+        return -1;
+
+    // channels on a blend that disappears keep its first IR
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+    {
+        if (chanIR.at(chanCnt) >= numIR)
+            chanIR.at(chanCnt) = blendIRA.at(chanIR.at(chanCnt)-numIR);
+    }
+
+    blendSpectra.resize(numSlots);
+    blendIRA.assign(numSlots, 0);
+    blendIRB.assign(numSlots, 0);
+    blendStep.assign(numSlots, 0);
+    blendUse.assign(numSlots, 0);
+    blendVersionA.assign(numSlots, 0);
+    blendVersionB.assign(numSlots, 0);
+    numBlendSteps = numSteps;
+
+    irParts.resize(numIR+numSlots, NULL);
+    partOffsets.resize((numIR+numSlots)*numChansIR, 0);
+    for (slotCnt=0; slotCnt<numSlots; slotCnt++)
+    {
+        if (!blendSpectra.at(slotCnt))
+        {
+            blendSpectra.at(slotCnt).reset(new IRSpectra);
+            allocSpectra(*blendSpectra.at(slotCnt), 1);
+        }
+        irParts.at(numIR+slotCnt) = blendSpectra.at(slotCnt)->parts.data();
+    }
+
+    return 0;
+}
+
+int TVOLAP::setIRBlend(uint32_t irA, uint32_t irB, double alpha)
+{
+    return setIRBlend(0, numChansIR, irA, irB, alpha);
+}
+
+int TVOLAP::setIRBlend(uint32_t firstChan, uint32_t numChans, uint32_t irA, uint32_t irB, double alpha)
+{
+    uint32_t step, slotIdx, slotCnt, chanCnt, partCnt, sampleCnt, versionA, versionB;
+    uint64_t blockCnt = inSampleCnt.load(std::memory_order_relaxed)/blockLen, guardBlocks;
+    double weightA, weightB;
+    bool canBlend = true;
+
+    if (irA >= numIR || irB >= numIR || alpha < 0.0 || alpha > 1.0 || firstChan >= numChansIR || numChans > numChansIR-firstChan)
+        return -1;
+
+    // in async mode process() runs on the worker, so no caller could share its thread
+    if (blendSpectra.empty() || async)
+        return -1;
+
+    // one key per pair, irA is the smaller index
+    if (irA > irB)
+    {
+        std::swap(irA, irB);
+        alpha = 1.0-alpha;
+    }
+    step = uint32_t(alpha*numBlendSteps+0.5);
+
+    // IRs that are delayed by different numbers of partitions (minimum phase bank) cannot be added
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+        canBlend = canBlend && partOffsets[irA*numChansIR+chanCnt] == partOffsets[irB*numChansIR+chanCnt];
+
+    if (irA == irB || step == 0 || (!canBlend && 2*step < numBlendSteps))
+        return setIR(firstChan, numChans, irA);
+    if (step == numBlendSteps || !canBlend)
+        return setIR(firstChan, numChans, irB);
+
+    // a replaced IR (stageIR(), loadIR()) has a new version, so its old blends do not match any more
+    versionA = irVersion[irA].load(std::memory_order_acquire);
+    versionB = irVersion[irB].load(std::memory_order_acquire);
+    for (slotIdx=0; slotIdx<blendSpectra.size(); slotIdx++)
+    {
+        if (blendIRA[slotIdx] == irA && blendIRB[slotIdx] == irB && blendStep[slotIdx] == step &&
+                blendVersionA[slotIdx] == versionA && blendVersionB[slotIdx] == versionB)
+            break;
+    }
+
+    if (slotIdx == blendSpectra.size())
+    {
+        // blocks in flight in the pipeline may still read a slot
+        guardBlocks = pipeline ? BLEND_GUARD_BLOCKS : 0;
+        for (slotCnt=0; slotCnt<blendSpectra.size(); slotCnt++)
+        {
+            for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+            {
+                if ((chanIR[chanCnt] == numIR+slotCnt && (chanCnt < firstChan || chanCnt >= firstChan+numChans)) ||
+                        fadesFromIR(chanCnt, numIR+slotCnt))
+                    break;
+            }
+
+            if ((blendStep[slotCnt] == 0 || (blendUse[slotCnt]+guardBlocks <= blockCnt && chanCnt == numChansIR)) &&
+                    (slotIdx == blendSpectra.size() || blendUse[slotCnt] < blendUse[slotIdx]))
+                slotIdx = slotCnt;
+        }
+
+        // all slots are selected or may still be read by a block in flight
+        if (slotIdx == blendSpectra.size())
+            return -1;
+
+        weightB = double(step)/numBlendSteps;
+        weightA = 1.0-weightB;
+        for (partCnt=0; partCnt<numChansIR*numParts; partCnt++)
+        {
+            const complex_float64 *partA = irParts[irA][partCnt], *partB = irParts[irB][partCnt];
+            complex_float64 *bins = &blendSpectra[slotIdx]->bins[partCnt*(processLen+1)];
+
+            for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
+                bins[sampleCnt] = complex_add(complex_mulr(partA[sampleCnt], weightA), complex_mulr(partB[sampleCnt], weightB));
+        }
+
+        std::copy(partOffsets.begin()+irA*numChansIR, partOffsets.begin()+(irA+1)*numChansIR,
+                partOffsets.begin()+(numIR+slotIdx)*numChansIR);
+        blendIRA[slotIdx] = irA;
+        blendIRB[slotIdx] = irB;
+        blendStep[slotIdx] = step;
+        blendVersionA[slotIdx] = versionA;
+        blendVersionB[slotIdx] = versionB;
+    }
+
+    blendUse[slotIdx] = blockCnt;
+    std::fill(chanIR.begin()+firstChan, chanIR.begin()+firstChan+numChans, numIR+slotIdx);
+
+    return 0;
+}
+
+void TVOLAP::touchBlends()
+{
+    uint64_t blockCnt = inSampleCnt.load(std::memory_order_relaxed)/blockLen;
+    uint32_t chanCnt;
+
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+    {
+        if (chanIR[chanCnt] >= numIR)
+            blendUse[chanIR[chanCnt]-numIR] = blockCnt;
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
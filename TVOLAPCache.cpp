@@ -0,0 +1,382 @@
+/*-----------------------------------------------------------------------------*\
+| IR banks that are too large for transformed spectra in memory, or that are    |
+| only used in parts. The time domain IRs stay in a memory mapped file or with  |
+| the caller, the filter spectra of the IRs in use are computed on demand into  |
+| a fixed number of cache slots. A cache smaller than the bank allocates its    |
+| slots at construction from the memory limit and a miss overwrites the least   |
+| recently used slot, so the real time thread never allocates. A cache for the  |
+| whole bank (lazy construction) allocates a slot when it is filled first, so   |
+| memory and startup time scale with the IRs actually used. With deferred       |
+| misses the transform and the allocation run on the prefetch thread. The cache |
+| is only touched by the thread that reads the spectra (process(), the MAC      |
+| thread of the pipeline or the caller of processOffline()).                    |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <stdexcept>
+#include <algorithm>
+#include "ThreadPool.h"
+#include "TVOLAPAsync.h"
+#include "TVOLAPCache.h"
+#include "TVOLAPEvents.h"
+#include "TVOLAPPipeline.h"
+
+TVOLAP::TVOLAP(const char *irBankFile, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+             uint32_t blockLen, uint32_t numChansAudio, uint64_t maxCacheBytes)
+{
+    init(numIR, lenIR, numChansIR, blockLen, numChansAudio);
+    initCache(lenIR, maxCacheBytes);
+
+    if (irCache->file.open(irBankFile) < 0)
+        throw std::runtime_error("IR bank file cannot be mapped.");
+
+    if (irCache->file.getSize() < uint64_t(numIR)*numChansIR*lenIR*sizeof(double))
+        throw std::runtime_error("IR bank file is too short."
+                "Must hold number of IRs * length of one IR * number of IR channels doubles.");
+
+    irCache->samples = (const double *) irCache->file.getData();
+}
+
+TVOLAP::TVOLAP(const double *interleavedIR, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+             uint32_t blockLen, uint32_t numChansAudio, MissMode missMode, uint64_t maxCacheBytes)
+{
+    if (interleavedIR == NULL)
+        throw std::runtime_error("Impulse response is missing.");
+
+    init(numIR, lenIR, numChansIR, blockLen, numChansAudio);
+    initCache(lenIR, maxCacheBytes);
+    irCache->samples = interleavedIR;
+
+    if (setMissMode(missMode) < 0)
+        throw std::runtime_error("Miss mode is not supported.");
+}
+
+TVOLAP::TVOLAP(IRProvider provider, void *context, uint32_t numIR, uint32_t lenIR, uint32_t numChansIR,
+             uint32_t blockLen, uint32_t numChansAudio, MissMode missMode, uint64_t maxCacheBytes)
+{
+    if (provider == NULL)
+        throw std::runtime_error("Impulse response provider is missing.");
+
+    init(numIR, lenIR, numChansIR, blockLen, numChansAudio);
+    initCache(lenIR, maxCacheBytes);
+    irCache->provider = provider;
+    irCache->context = context;
+
+    if (setMissMode(missMode) < 0)
+        throw std::runtime_error("Miss mode is not supported.");
+}
+
+TVOLAP::TVOLAP(std::shared_ptr<const BasisBank> basisBank, uint32_t numChansAudio, MissMode missMode, uint64_t maxCacheBytes)
+{
+    if (!basisBank)
+        throw std::runtime_error("Basis bank is missing.");
+
+    init(basisBank->getNumIR(), basisBank->getLenIR(), basisBank->getNumChansIR(), basisBank->getBlockLen(), numChansAudio);
+
+    // by default the reconstructed spectra take about as much memory as the basis itself
+    if (maxCacheBytes == 0)
+    {
+        maxCacheBytes = uint64_t(numChansIR)*numParts*(processLen+1)*sizeof(complex_float64)*
+                std::max(basisBank->getNumBasis()+1, std::min(numChansAudio, numChansIR));
+    }
+    initCache(basisBank->getLenIR(), maxCacheBytes);
+    irCache->basisBank = basisBank;
+
+    if (setMissMode(missMode) < 0)
+        throw std::runtime_error("Miss mode is not supported.");
+}
+
+void TVOLAP::initCache(uint32_t lenIR, uint64_t maxCacheBytes)
+{
+    uint64_t bytesPerIR = uint64_t(numChansIR)*numParts*(processLen+1)*sizeof(complex_float64);
+    uint32_t slotCnt;
+
+    // every channel may use another IR within one block
+    if (maxCacheBytes/bytesPerIR < std::min(numIR, std::min(numChansAudio, numChansIR)))
+        throw std::runtime_error("Cache size is too small for the filter spectra of one IR per channel.");
+
+    irCache.reset(new IRCache(numIR));
+    irCache->samples = NULL;
+    irCache->provider = NULL;
+    irCache->context = NULL;
+    irCache->lenIR = lenIR;
+    irCache->numSlots = uint32_t(std::min(maxCacheBytes/bytesPerIR, uint64_t(numIR)));
+    irCache->useCnt = 0;
+    irCache->missMode = MISS_TRANSFORM;
+    irCache->slotIR.resize(irCache->numSlots, numIR);
+    irCache->slotUse.resize(irCache->numSlots, 0);
+    irCache->irSlot.resize(numIR, irCache->numSlots);
+    irCache->irUsed.resize(numIR, false);
+    irCache->readyIR.resize(numChansIR, 0);
+    irCache->slotStorage.resize(irCache->numSlots);
+    irCache->slotBins.resize(irCache->numSlots, NULL);
+    irCache->slotParts.resize(irCache->numSlots, NULL);
+
+    // a cache for the whole bank grows with the IRs in use, a smaller one takes its memory up front
+    if (irCache->numSlots < numIR)
+    {
+        for (slotCnt=0; slotCnt<irCache->numSlots; slotCnt++)
+            allocCacheSlot(slotCnt);
+    }
+
+    irCache->tmpPartIR.resize(nfft);
+    irCache->numHits.store(0);
+    irCache->numMisses.store(0);
+    irCache->numEvictions.store(0);
+    irCache->numPrefetches.store(0);
+    irCache->numFailures.store(0);
+    irCache->numResident.store(0);
+}
+
+void TVOLAP::allocCacheSlot(uint32_t slotIdx)
+{
+    IRCache &cache = *irCache;
+
+    cache.slotStorage.at(slotIdx).reset(new IRSpectra);
+    allocSpectra(*cache.slotStorage.at(slotIdx), 1);
+    cache.slotBins.at(slotIdx) = cache.slotStorage.at(slotIdx)->bins.data();
+    cache.slotParts.at(slotIdx) = cache.slotStorage.at(slotIdx)->parts.data();
+}
+
+int TVOLAP::setMissMode(MissMode missMode)
+{
+    uint32_t chanCnt, useStamp, numProcChans = std::min(numChansAudio, numChansIR);
+
+    if (!irCache || (missMode != MISS_TRANSFORM && missMode != MISS_DEFER))
+        return -1;
+
+    // the prefetched IR needs a slot besides the ones of the last block
+    if (missMode == MISS_DEFER && irCache->numSlots < numIR && irCache->numSlots <= numProcChans)
+        return -1;
+
+    irCache->missMode = missMode;
+
+    // a deferred miss falls back to the IR of the last block, which has to be resident from the start
+    if (missMode == MISS_DEFER)
+    {
+        useStamp = nextUseStamp();
+        for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+        {
+            irCache->readyIR.at(chanCnt) = chanIR.at(chanCnt);
+            acquireIR(chanIR.at(chanCnt), useStamp);
+        }
+    }
+
+    // the prefetch thread also serves the deferred misses
+    return setPrefetch(prefetch ? prefetch->numAhead : 0, prefetch ? prefetch->cpuIdx : -1);
+}
+
+int TVOLAP::pollFirstUse(uint32_t &irIdx)
+{
+    if (!irCache)
+        return -1;
+
+    if (!irCache->firstUse.isReadable())
+        return 1;
+
+    irIdx = irCache->firstUse.readSlot();
+    irCache->firstUse.pop();
+
+    return 0;
+}
+
+int TVOLAP::getCacheStats(CacheStats &stats) const
+{
+    uint64_t bytesPerIR = uint64_t(numChansIR)*numParts*(processLen+1)*sizeof(complex_float64);
+
+    if (!irCache)
+        return -1;
+
+    stats.numHits = irCache->numHits.load(std::memory_order_relaxed);
+    stats.numMisses = irCache->numMisses.load(std::memory_order_relaxed);
+    stats.numEvictions = irCache->numEvictions.load(std::memory_order_relaxed);
+    stats.numPrefetches = irCache->numPrefetches.load(std::memory_order_relaxed);
+    stats.numFailures = irCache->numFailures.load(std::memory_order_relaxed);
+    stats.residentBytes = irCache->numResident.load(std::memory_order_relaxed)*bytesPerIR;
+    stats.maxResidentBytes = irCache->numSlots*bytesPerIR;
+
+    return 0;
+}
+
+uint32_t TVOLAP::nextUseStamp()
+{
+    return irCache ? ++irCache->useCnt : 0;
+}
+
+void TVOLAP::acquireChannelIRs(std::vector<uint32_t> &procIR)
+{
+    uint32_t chanCnt, useStamp, fadeIR, numProcChans = std::min(numChansAudio, numChansIR);
+
+    if (!irCache)
+        return;
+
+    IRCache &cache = *irCache;
+
+    if (prefetch)
+        adoptPrefetched();
+
+    // one stamp for all channels, so they do not evict each other
+    useStamp = nextUseStamp();
+    for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+    {
+        // a deferred IR is requested from the prefetch thread, the channel keeps its IR until it is ready
+        if (cache.missMode == MISS_DEFER && irParts[procIR[chanCnt]] == NULL)
+        {
+            requestIR(procIR[chanCnt]);
+            procIR[chanCnt] = cache.readyIR[chanCnt];
+        }
+
+        acquireIR(procIR[chanCnt], useStamp);
+        cache.readyIR[chanCnt] = procIR[chanCnt];
+    }
+
+    // the previous IR of a crossfade is kept while resident, it is not loaded again
+    if (parallelMode != PARALLEL_PIPELINE)
+    {
+        for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+        {
+            EventFade &fade = events->fades[chanCnt];
+
+            fadeIR = fade.active ? fade.srcIR : fade.lastIR;
+            if ((fade.active || fade.requested) && irParts[fadeIR] != NULL)
+                acquireIR(fadeIR, useStamp);
+        }
+    }
+
+    if (prefetch)
+        requestPrefetch(procIR);
+}
+
+void TVOLAP::transformBankIR(uint32_t irIdx, complex_float64 *bins, std::vector<double> &tmpPartIR) const
+{
+    uint32_t partCnt, partBeg, partLen, sampleCnt, numPartsIR = numChansIR*numParts, lenIR = irCache->lenIR;
+
+    if (irCache->basisBank)
+    {
+        irCache->basisBank->reconstruct(irIdx, bins);
+        return;
+    }
+
+    for (partCnt=0; partCnt<numPartsIR; partCnt++)
+    {
+        partBeg = std::min((partCnt%numParts)*processLen, lenIR);
+        partLen = std::min(processLen, lenIR-partBeg);
+
+        if (irCache->provider == NULL)
+        {
+            FilterBank::transformPartition(irCache->samples+(uint64_t(irIdx)*numChansIR+partCnt/numParts)*lenIR+partBeg, partLen,
+                    bins+partCnt*(processLen+1), tmpPartIR);
+            continue;
+        }
+
+        // nothing can be thrown here, a failed partition stays silent and is counted
+        if (irCache->provider(irCache->context, irIdx, partCnt/numParts, partBeg, partLen, tmpPartIR.data()) < 0)
+        {
+            irCache->numFailures.fetch_add(1, std::memory_order_relaxed);
+            partLen = 0;
+        }
+
+        for (sampleCnt=partLen; sampleCnt<nfft; sampleCnt++)
+            tmpPartIR[sampleCnt] = 0.0;
+
+        rfft_double(tmpPartIR.data(), bins+partCnt*(processLen+1), nfft);
+    }
+}
+
+bool TVOLAP::acquireIR(uint32_t irIdx, uint32_t useStamp)
+{
+    uint32_t victim;
+
+    if (!irCache)
+        return true;
+
+    IRCache &cache = *irCache;
+
+    if (!cache.irUsed[irIdx])
+    {
+        cache.irUsed[irIdx] = true;
+        cache.firstUse.writeSlot() = irIdx;
+        cache.firstUse.push();
+    }
+
+    // resident or replaced by stageIR()
+    if (irParts[irIdx] != NULL)
+    {
+        if (cache.irSlot[irIdx] < cache.numSlots)
+            cache.slotUse[cache.irSlot[irIdx]] = useStamp;
+        cache.numHits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    victim = evictCacheSlot(useStamp);
+    if (victim == cache.numSlots)
+        return false;
+
+    if (cache.slotBins[victim] == NULL)
+        allocCacheSlot(victim);
+
+    transformBankIR(irIdx, cache.slotBins[victim], cache.tmpPartIR);
+
+    cache.slotIR[victim] = irIdx;
+    cache.slotUse[victim] = useStamp;
+    cache.irSlot[irIdx] = victim;
+    irParts[irIdx] = cache.slotParts[victim];
+    cache.numMisses.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+uint32_t TVOLAP::evictCacheSlot(uint32_t useStamp)
+{
+    IRCache &cache = *irCache;
+    uint32_t slotCnt, victim = cache.numSlots, oldIR;
+
+    // empty slot or the least recently used one, slots used under the same stamp are pinned
+    for (slotCnt=0; slotCnt<cache.numSlots; slotCnt++)
+    {
+        if (cache.slotIR[slotCnt] == numIR)
+        {
+            victim = slotCnt;
+            break;
+        }
+
+        if (cache.slotUse[slotCnt] != useStamp &&
+                (victim == cache.numSlots || useStamp-cache.slotUse[slotCnt] > useStamp-cache.slotUse[victim]))
+            victim = slotCnt;
+    }
+
+    if (victim == cache.numSlots)
+        return victim;
+
+    oldIR = cache.slotIR[victim];
+    if (oldIR < numIR)
+    {
+        cache.irSlot[oldIR] = cache.numSlots;
+        if (irParts[oldIR] == cache.slotParts[victim])
+            irParts[oldIR] = NULL;
+        cache.numEvictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+        cache.numResident.fetch_add(1, std::memory_order_relaxed);
+
+    return victim;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,83 @@
+/*-----------------------------------------------------------------------------*\
+| Private header of TVOLAPCache.cpp, for explanation see cpp-file.              |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef TVOLAPCACHE_H
+#define TVOLAPCACHE_H
+
+#include <thread>
+#include "TVOLAP.h"
+#include "BasisBank.h"
+#include "MappedFile.h"
+#include "SPSCRing.h"
+
+// the spectra of a slot are exchanged with prefetched ones, so every slot points to its buffer
+struct TVOLAP::IRCache
+{
+    IRCache(uint32_t numIR) : firstUse(numIR, 0) {}
+
+    MappedFile file;
+    const double *samples;
+    IRProvider provider;
+    void *context;
+    std::shared_ptr<const BasisBank> basisBank;
+    uint32_t lenIR, numSlots, useCnt;
+    MissMode missMode;
+    std::vector<uint32_t> slotIR, slotUse, irSlot, readyIR;
+    std::vector<bool> irUsed;
+    std::vector< std::unique_ptr<IRSpectra> > slotStorage;
+    std::vector<complex_float64 *> slotBins;
+    std::vector<const complex_float64 * const *> slotParts;
+    std::vector<double> tmpPartIR;
+    SPSCRing<uint32_t> firstUse;
+    std::atomic<uint64_t> numHits, numMisses, numEvictions, numPrefetches, numFailures;
+    std::atomic<uint32_t> numResident;
+};
+
+// a buffer without bins asks the prefetch thread to allocate the storage of a slot first
+struct TVOLAP::Prefetch
+{
+    struct Buffer
+    {
+        complex_float64 *bins;
+        const complex_float64 * const *parts;
+        std::unique_ptr<IRSpectra> *storage;
+        uint32_t irIdx;
+    };
+
+    Prefetch(uint32_t numBuffers, uint32_t numRequests)
+        : requests(numRequests, 0), freeBuffers(numBuffers, Buffer()), doneBuffers(numBuffers, Buffer()) {}
+
+    SPSCRing<uint32_t> requests;
+    SPSCRing<Buffer> freeBuffers, doneBuffers;
+    uint32_t numAhead;
+    int cpuIdx;
+    std::vector<uint32_t> lastIR;
+    std::vector<int64_t> lastStep;
+    std::vector<bool> irPending;
+    std::vector<double> tmpPartIR;
+    std::atomic<bool> quit;
+    std::thread worker;
+};
+
+#endif // TVOLAPCACHE_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,76 @@
+/*-----------------------------------------------------------------------------*\
+| Direction based IR selection for head tracking. The IR positions are kept in  |
+| a k-d tree (DirectionIndex), so the lookup cost hardly grows with the size of |
+| the HRIR database. The hysteresis keeps the actual IR while the direction     |
+| moves along the border between two grid points, so noisy tracker data does    |
+| not toggle between them every block.                                          |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <cmath>
+#include "TVOLAP.h"
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+int TVOLAP::setPositions(const std::vector<double> &azimuth, const std::vector<double> &elevation,
+        const std::vector<double> &distance, double hysteresis)
+{
+    if (azimuth.size() != numIR || hysteresis < 0.0 || hysteresis >= 180.0)
+        return -1;
+
+    if (dirIndex.build(azimuth, elevation, distance) < 0)
+        return -1;
+
+    // chord length of the hysteresis angle on the unit sphere
+    dirHysteresis = 2.0*sin(hysteresis*M_PI/360.0);
+
+    return 0;
+}
+
+int TVOLAP::findIR(double azimuth, double elevation, double distance, uint32_t prevIR) const
+{
+    if (dirIndex.getNumPositions() == 0)
+        return -1;
+
+    return int(dirIndex.findNearest(azimuth, elevation, distance, prevIR, dirHysteresis));
+}
+
+int TVOLAP::setDirection(double azimuth, double elevation, double distance)
+{
+    return setDirection(0, numChansIR, azimuth, elevation, distance);
+}
+
+int TVOLAP::setDirection(uint32_t firstChan, uint32_t numChans, double azimuth, double elevation, double distance)
+{
+    int actIR;
+
+    if (firstChan >= numChansIR)
+        return -1;
+
+    actIR = findIR(azimuth, elevation, distance, chanIR[firstChan]);
+    if (actIR < 0 || setIR(firstChan, numChans, uint32_t(actIR)) < 0)
+        return -1;
+
+    return actIR;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
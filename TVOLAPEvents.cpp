@@ -0,0 +1,314 @@
+/*-----------------------------------------------------------------------------*\
+| Sample timed IR selection from a second thread (e.g. a head tracker).         |
+| queueIR() pushes events into a wait-free single producer / single consumer    |
+| ring, process() pops them at the start of every block. The partition size is  |
+| fixed, so an event inside a block is rendered by an equivalent mechanism: the |
+| channel goes on with its previous IR and a copy of the overlap state, the     |
+| overlap state of the new IR is computed again from the frequency delay line   |
+| as if it had always been selected, and the outputs of both are crossfaded     |
+| with a raised cosine of IR_EVENT_FADE_LEN samples that starts at the time     |
+| stamp of the event. The switch is therefore sample accurate for any block     |
+| length and callback size. In pipeline mode events take effect at the block    |
+| whose windowed crossfade is centered nearest to the time stamp (at most half  |
+| a block off).                                                                 |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cmath>
+#include "TVOLAPEvents.h"
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+int TVOLAP::queueIR(uint64_t sampleIdx, uint32_t firstChan, uint32_t numChans, uint32_t actIR)
+{
+    EventQueue &queue = *events;
+
+    if (actIR >= numIR || firstChan >= numChansIR || numChans > numChansIR-firstChan || !queue.ring.isWritable())
+    {
+        queue.numRejected.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    IREvent &event = queue.ring.writeSlot();
+    event.sampleIdx = sampleIdx;
+    event.firstChan = firstChan;
+    event.numChans = numChans;
+    event.actIR = actIR;
+    queue.ring.push();
+
+    return 0;
+}
+
+uint64_t TVOLAP::getSampleCnt() const
+{
+    return inSampleCnt.load(std::memory_order_acquire);
+}
+
+int TVOLAP::getEventStats(EventStats &stats) const
+{
+    const EventQueue &queue = *events;
+    double meanLatency;
+
+    stats.numEvents = queue.numEvents.load(std::memory_order_relaxed);
+    stats.numRejected = queue.numRejected.load(std::memory_order_relaxed);
+    stats.minLatency = queue.minLatency.load(std::memory_order_relaxed);
+    stats.maxLatency = queue.maxLatency.load(std::memory_order_relaxed);
+    stats.meanLatency = stats.jitter = 0.0;
+
+    if (stats.numEvents == 0)
+        return 0;
+
+    meanLatency = double(queue.sumLatency.load(std::memory_order_relaxed))/stats.numEvents;
+    stats.meanLatency = meanLatency;
+    stats.jitter = sqrt(std::max(double(queue.sumSqLatency.load(std::memory_order_relaxed))/stats.numEvents-meanLatency*meanLatency, 0.0));
+
+    return 0;
+}
+
+void TVOLAP::applyEvents()
+{
+    EventQueue &queue = *events;
+    uint64_t blockBeg = inSampleCnt.load(std::memory_order_relaxed), numEvents;
+    int64_t latency, outBeg = int64_t(blockBeg)-int64_t(blockLen);
+    uint32_t chanCnt, fadeBeg, heldBeg;
+
+    // the output of this block belongs to the input samples outBeg ... blockBeg-1
+    while (queue.ring.isReadable())
+    {
+        const IREvent &event = queue.ring.readSlot();
+        if (event.sampleIdx >= blockBeg)
+            break;
+
+        std::fill(chanIR.begin()+event.firstChan, chanIR.begin()+event.firstChan+event.numChans, event.actIR);
+
+        if (parallelMode == PARALLEL_PIPELINE)
+        {
+            // the windowed crossfade of this block is centered blockLen/2 samples before blockBeg
+            latency = int64_t(blockBeg-blockLen/2-event.sampleIdx);
+        }
+        else
+        {
+            // a late event fades from the start of the block, during a crossfade from the block after its end
+            fadeBeg = uint32_t(std::max(int64_t(event.sampleIdx)-outBeg, int64_t(0)));
+            heldBeg = fadeBeg;
+            for (chanCnt=event.firstChan; chanCnt<event.firstChan+event.numChans; chanCnt++)
+            {
+                EventFade &fade = queue.fades[chanCnt];
+
+                if (fade.active)
+                    heldBeg = std::max(heldBeg, (IR_EVENT_FADE_LEN-fade.fadePos+blockLen-1)/blockLen*blockLen);
+                else
+                    fade.fadeBeg = fadeBeg;
+                fade.requested = true;
+            }
+            latency = int64_t(outBeg+heldBeg+IR_EVENT_FADE_LEN/2)-int64_t(event.sampleIdx);
+        }
+
+        // only this thread writes the statistics, the atomics just make them readable from others
+        numEvents = queue.numEvents.load(std::memory_order_relaxed);
+        if (numEvents == 0 || latency < queue.minLatency.load(std::memory_order_relaxed))
+            queue.minLatency.store(latency, std::memory_order_relaxed);
+        if (numEvents == 0 || latency > queue.maxLatency.load(std::memory_order_relaxed))
+            queue.maxLatency.store(latency, std::memory_order_relaxed);
+        queue.sumLatency.store(queue.sumLatency.load(std::memory_order_relaxed)+latency, std::memory_order_relaxed);
+        queue.sumSqLatency.store(queue.sumSqLatency.load(std::memory_order_relaxed)+uint64_t(latency*latency), std::memory_order_relaxed);
+        queue.numEvents.store(numEvents+1, std::memory_order_relaxed);
+
+        queue.ring.pop();
+    }
+
+    inSampleCnt.store(blockBeg+blockLen, std::memory_order_release);
+}
+
+void TVOLAP::initFades()
+{
+    uint32_t chanCnt, sampleCnt;
+
+    events->fades.resize(numChansIR);
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+    {
+        EventFade &fade = events->fades.at(chanCnt);
+
+        fade.srcIR = fade.lastIR = 0;
+        fade.fadeBeg = fade.fadePos = 0;
+        fade.requested = fade.active = fade.restart = false;
+        fade.convMem.assign(overlapFact, std::vector<double>(processLen, 0.0));
+        fade.outBlockMem.assign(blockLen, 0.0);
+    }
+
+    events->fadeWin.resize(IR_EVENT_FADE_LEN);
+    for (sampleCnt=0; sampleCnt<IR_EVENT_FADE_LEN; sampleCnt++)
+        events->fadeWin.at(sampleCnt) = 0.5-0.5*cos(M_PI*(sampleCnt+0.5)/IR_EVENT_FADE_LEN);
+}
+
+void TVOLAP::holdFadingIRs()
+{
+    uint32_t chanCnt, numProcChans = std::min(numChansAudio, numChansIR);
+
+    // a new selection waits until the running crossfade of the channel is done
+    for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+    {
+        if (events->fades[chanCnt].active)
+            procIR[chanCnt] = events->fades[chanCnt].lastIR;
+    }
+}
+
+void TVOLAP::startFades()
+{
+    uint32_t chanCnt, numProcChans = std::min(numChansAudio, numChansIR);
+
+    for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+    {
+        EventFade &fade = events->fades[chanCnt];
+
+        // setIR() switches with the windows of the blocks, as does an event if the cache lost the previous IR
+        if (procIR[chanCnt] != fade.lastIR)
+        {
+            if (fade.requested && (!irCache || irParts[fade.lastIR] != NULL))
+            {
+                fade.srcIR = fade.lastIR;
+                fade.fadePos = 0;
+                fade.active = fade.restart = true;
+            }
+            fade.lastIR = procIR[chanCnt];
+        }
+
+        // an event that is deferred (IR cache, running crossfade) fades from the start of a later block
+        if (fade.restart || procIR[chanCnt] == chanIR[chanCnt])
+            fade.requested = false;
+        else
+            fade.fadeBeg = 0;
+    }
+}
+
+bool TVOLAP::fadesFromIR(uint32_t chanCnt, uint32_t irIdx) const
+{
+    const EventFade &fade = events->fades[chanCnt];
+
+    return (fade.active && fade.srcIR == irIdx) || (fade.requested && fade.lastIR == irIdx);
+}
+
+void TVOLAP::macDelayed(uint32_t chanCnt, uint32_t irIdx, uint32_t delay, complex_float64 *spectrumSum)
+{
+    uint32_t partCnt, sampleCnt, partOffset = partOffsets[irIdx*numChansIR+chanCnt];
+    int32_t freqReadCnt;
+
+    for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
+        spectrumSum[sampleCnt].re = spectrumSum[sampleCnt].im = 0.0;
+
+    // the block delay blocks before the actual one, the delay line holds IR_EVENT_HISTORY blocks more than the MAC needs
+    freqReadCnt = int32_t(freqSaveCnt)-int32_t((delay+partOffset*overlapFact)%numMems);
+    if (freqReadCnt<0)
+        freqReadCnt+=numMems;
+
+    MacKernel mac = macKernel;
+    const void * const *parts = filterParts(irIdx)+chanCnt*numParts;
+
+    for (partCnt=0; partCnt<numParts; partCnt++)
+    {
+        mac(spectrumSum, inSpectrum[chanCnt][freqReadCnt].data(), parts[partCnt], processLen+1);
+
+        freqReadCnt-=overlapFact;
+        if (freqReadCnt<0)
+            freqReadCnt+=numMems;
+    }
+}
+
+void TVOLAP::beginFade(uint32_t chanCnt, uint32_t threadIdx)
+{
+    EventFade &fade = events->fades[chanCnt];
+    std::vector<double> &ifftBlock = this->ifftBlock[threadIdx];
+    complex_float64 *spectrumSum = inSpectrumSum[threadIdx].data();
+    uint32_t sampleCnt, irIdx = procIR[chanCnt], prevSaveCnt = (convSaveCnt+1)%overlapFact;
+
+    // the previous IR goes on with the actual overlap state
+    fade.convMem[convSaveCnt].swap(convMem[chanCnt][convSaveCnt]);
+    fade.convMem[prevSaveCnt].swap(convMem[chanCnt][prevSaveCnt]);
+    fade.outBlockMem.swap(outBlockMem[chanCnt]);
+
+    // overlap state of the new IR: convMem holds the tails of the blocks n-2 and n-1, outBlockMem
+    // the second half of the output of block n-1 including the tail of block n-3
+    macDelayed(chanCnt, irIdx, 3, spectrumSum);
+    irfft_double(spectrumSum, ifftBlock.data(), nfft);
+    for (sampleCnt=0; sampleCnt<blockLen; sampleCnt++)
+        outBlockMem[chanCnt][sampleCnt] = ifftBlock[sampleCnt+processLen+blockLen];
+
+    macDelayed(chanCnt, irIdx, 2, spectrumSum);
+    irfft_double(spectrumSum, ifftBlock.data(), nfft);
+    for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+        convMem[chanCnt][convSaveCnt][sampleCnt] = ifftBlock[sampleCnt+processLen];
+
+    macDelayed(chanCnt, irIdx, 1, spectrumSum);
+    irfft_double(spectrumSum, ifftBlock.data(), nfft);
+    for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+        convMem[chanCnt][prevSaveCnt][sampleCnt] = ifftBlock[sampleCnt+processLen];
+    for (sampleCnt=0; sampleCnt<blockLen; sampleCnt++)
+        outBlockMem[chanCnt][sampleCnt] += ifftBlock[sampleCnt+blockLen];
+
+    fade.restart = false;
+}
+
+void TVOLAP::mixFade(uint32_t chanCnt, uint32_t threadIdx)
+{
+    EventFade &fade = events->fades[chanCnt];
+    std::vector<double> &ifftBlock = this->ifftBlock[threadIdx], &oldBlock = inBlockWin[threadIdx];
+    complex_float64 *spectrumSum = inSpectrumSum[threadIdx].data();
+    const double *fadeWin = events->fadeWin.data();
+    uint32_t sampleCnt, fadeCnt;
+    double oldSample;
+
+    // the cache had to drop the previous IR, the channel jumps to the new one
+    if (irCache && irParts[fade.srcIR] == NULL)
+    {
+        fade.active = false;
+        return;
+    }
+
+    macDelayed(chanCnt, fade.srcIR, 0, spectrumSum);
+    irfft_double(spectrumSum, ifftBlock.data(), nfft);
+
+    for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+    {
+        oldBlock[sampleCnt] = ifftBlock[sampleCnt]+fade.convMem[convSaveCnt][sampleCnt];
+        fade.convMem[convSaveCnt][sampleCnt] = ifftBlock[sampleCnt+processLen];
+    }
+
+    // outBlock holds the output of the new IR
+    for (sampleCnt=0, fadeCnt=fade.fadePos; sampleCnt<blockLen; sampleCnt++)
+    {
+        oldSample = oldBlock[sampleCnt]+fade.outBlockMem[sampleCnt];
+        fade.outBlockMem[sampleCnt] = oldBlock[sampleCnt+blockLen];
+
+        if (sampleCnt < fade.fadeBeg)
+            outBlock[chanCnt][sampleCnt] = oldSample;
+        else if (fadeCnt < IR_EVENT_FADE_LEN)
+            outBlock[chanCnt][sampleCnt] = oldSample+fadeWin[fadeCnt++]*(outBlock[chanCnt][sampleCnt]-oldSample);
+    }
+
+    fade.fadePos = fadeCnt;
+    fade.fadeBeg = 0;
+    if (fade.fadePos >= IR_EVENT_FADE_LEN)
+        fade.active = false;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
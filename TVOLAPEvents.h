@@ -0,0 +1,67 @@
+/*-----------------------------------------------------------------------------*\
+| Private header of TVOLAPEvents.cpp, only included by the TVOLAP sources.      |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef TVOLAPEVENTS_H
+#define TVOLAPEVENTS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "TVOLAP.h"
+#include "SPSCRing.h"
+
+#define IR_EVENT_QUEUE_SIZE 256
+// length of the crossfade of an event in samples
+#define IR_EVENT_FADE_LEN 128
+// blocks before the actual one that are filtered again with the new IR when a crossfade starts
+#define IR_EVENT_HISTORY 3
+
+struct TVOLAP::IREvent
+{
+    uint64_t sampleIdx;
+    uint32_t firstChan, numChans, actIR;
+};
+
+// crossfade of one IR channel from its previous IR, which goes on with a copy of the overlap
+// state, to the new IR, for which the overlap state was computed again
+struct TVOLAP::EventFade
+{
+    uint32_t srcIR, lastIR, fadeBeg, fadePos;
+    bool requested, active, restart;
+    std::vector< std::vector<double> > convMem;
+    std::vector<double> outBlockMem;
+};
+
+struct TVOLAP::EventQueue
+{
+    EventQueue() : ring(IR_EVENT_QUEUE_SIZE, IREvent()) {}
+
+    SPSCRing<IREvent> ring;
+    std::atomic<uint64_t> numEvents, numRejected, sumSqLatency;
+    std::atomic<int64_t> sumLatency, minLatency, maxLatency;
+    std::vector<EventFade> fades;
+    std::vector<double> fadeWin;
+};
+
+#endif // TVOLAPEVENTS_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
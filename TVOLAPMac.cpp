@@ -0,0 +1,192 @@
+/*-----------------------------------------------------------------------------*\
+| Multiply accumulate kernels of one filter partition into the double spectrum  |
+| sum, one per precision of the filter bank. TVOLAP selects the kernel once at  |
+| construction, the MAC loops look up the kernel and the partitions of the IR   |
+| once per block. The reduced formats only pay off if they are widened as fast  |
+| as they are loaded: with SSE2 four bins are widened per iteration in          |
+| registers (bfloat16 by interleaving with zero, int16 by a sign extending      |
+| shift), elsewhere plain loops over re and im arrays are left to the           |
+| vectorizer. The products are the same as of the float64 MAC on the widened    |
+| spectra.                                                                      |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <cstring>
+#include "TVOLAP.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TVOLAP_MAC_SSE2
+#endif
+
+// bins of a bfloat16 partition that are widened at once on the stack without SSE2
+#define MAC_CHUNK_BINS 64
+
+static inline void macWidened(double *sum, const double *in, const float *filter, uint32_t numBins)
+{
+    uint32_t sampleCnt;
+    double filterRe, filterIm, inRe, inIm;
+
+    for (sampleCnt=0; sampleCnt<numBins; sampleCnt++)
+    {
+        filterRe = filter[2*sampleCnt];
+        filterIm = filter[2*sampleCnt+1];
+        inRe = in[2*sampleCnt];
+        inIm = in[2*sampleCnt+1];
+        sum[2*sampleCnt] += inRe*filterRe-inIm*filterIm;
+        sum[2*sampleCnt+1] += inRe*filterIm+inIm*filterRe;
+    }
+}
+
+static inline void macBFloat16Loop(double *sum, const double *in, const uint16_t *filter, uint32_t numBins)
+{
+    uint32_t binBeg, chunkLen, valueCnt;
+    union
+    {
+        uint32_t bits[2*MAC_CHUNK_BINS];
+        float values[2*MAC_CHUNK_BINS];
+    } chunk;
+
+    // bfloat16 are the upper halves of float32, a chunk is widened as integers and read as float
+    for (binBeg=0; binBeg<numBins; binBeg+=chunkLen)
+    {
+        chunkLen = std::min(numBins-binBeg, uint32_t(MAC_CHUNK_BINS));
+        for (valueCnt=0; valueCnt<2*chunkLen; valueCnt++)
+            chunk.bits[valueCnt] = uint32_t(filter[2*binBeg+valueCnt]) << 16;
+
+        macWidened(sum+2*binBeg, in+2*binBeg, chunk.values, chunkLen);
+    }
+}
+
+static inline void macInt16Loop(double *sum, const double *in, const int16_t *filter, double scale, uint32_t numBins)
+{
+    uint32_t sampleCnt;
+    double filterRe, filterIm, inRe, inIm;
+
+    for (sampleCnt=0; sampleCnt<numBins; sampleCnt++)
+    {
+        filterRe = filter[2*sampleCnt]*scale;
+        filterIm = filter[2*sampleCnt+1]*scale;
+        inRe = in[2*sampleCnt];
+        inIm = in[2*sampleCnt+1];
+        sum[2*sampleCnt] += inRe*filterRe-inIm*filterIm;
+        sum[2*sampleCnt+1] += inRe*filterIm+inIm*filterRe;
+    }
+}
+
+#ifdef TVOLAP_MAC_SSE2
+// sum+in*filter of one bin, all three hold re in the low and im in the high lane
+static inline void macBin(double *sum, const double *in, __m128d filter)
+{
+    const __m128d negateRe = _mm_set_pd(0.0, -0.0);
+    __m128d inBin = _mm_loadu_pd(in), product;
+
+    product = _mm_mul_pd(inBin, _mm_unpacklo_pd(filter, filter));
+    product = _mm_add_pd(product, _mm_xor_pd(_mm_mul_pd(_mm_shuffle_pd(inBin, inBin, 1), _mm_unpackhi_pd(filter, filter)), negateRe));
+    _mm_storeu_pd(sum, _mm_add_pd(_mm_loadu_pd(sum), product));
+}
+#endif
+
+void TVOLAP::macFloat64(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins)
+{
+    macSpectrum(spectrumSum, inSpectrum, (const complex_float64 *) filterSpectrum, numBins);
+}
+
+void TVOLAP::macFloat32(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins)
+{
+    double *sum = (double *) spectrumSum;
+    const double *in = (const double *) inSpectrum;
+    const float *filter = (const float *) filterSpectrum;
+    uint32_t binCnt = 0;
+
+#ifdef TVOLAP_MAC_SSE2
+    __m128 values;
+
+    for (; binCnt+2<=numBins; binCnt+=2)
+    {
+        values = _mm_loadu_ps(filter+2*binCnt);
+        macBin(sum+2*binCnt, in+2*binCnt, _mm_cvtps_pd(values));
+        macBin(sum+2*binCnt+2, in+2*binCnt+2, _mm_cvtps_pd(_mm_movehl_ps(values, values)));
+    }
+#endif
+
+    macWidened(sum+2*binCnt, in+2*binCnt, filter+2*binCnt, numBins-binCnt);
+}
+
+void TVOLAP::macBFloat16(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins)
+{
+    double *sum = (double *) spectrumSum;
+    const double *in = (const double *) inSpectrum;
+    const uint16_t *filter = (const uint16_t *) filterSpectrum;
+    uint32_t binCnt = 0;
+
+#ifdef TVOLAP_MAC_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i packed;
+    __m128 low, high;
+
+    // interleaving zeros below the bfloat16 gives the float32 bits of four values per half
+    for (; binCnt+4<=numBins; binCnt+=4)
+    {
+        packed = _mm_loadu_si128((const __m128i *) (filter+2*binCnt));
+        low = _mm_castsi128_ps(_mm_unpacklo_epi16(zero, packed));
+        high = _mm_castsi128_ps(_mm_unpackhi_epi16(zero, packed));
+        macBin(sum+2*binCnt, in+2*binCnt, _mm_cvtps_pd(low));
+        macBin(sum+2*binCnt+2, in+2*binCnt+2, _mm_cvtps_pd(_mm_movehl_ps(low, low)));
+        macBin(sum+2*binCnt+4, in+2*binCnt+4, _mm_cvtps_pd(high));
+        macBin(sum+2*binCnt+6, in+2*binCnt+6, _mm_cvtps_pd(_mm_movehl_ps(high, high)));
+    }
+#endif
+
+    macBFloat16Loop(sum+2*binCnt, in+2*binCnt, filter+2*binCnt, numBins-binCnt);
+}
+
+void TVOLAP::macInt16(complex_float64 *spectrumSum, const complex_float64 *inSpectrum, const void *filterSpectrum, uint32_t numBins)
+{
+    double *sum = (double *) spectrumSum;
+    const double *in = (const double *) inSpectrum;
+    const int16_t *filter = (const int16_t *) ((const double *) filterSpectrum+1);
+    uint32_t binCnt = 0;
+    double scale;
+
+    memcpy(&scale, filterSpectrum, sizeof(scale));
+
+#ifdef TVOLAP_MAC_SSE2
+    const __m128d scaleVec = _mm_set1_pd(scale);
+    __m128i packed, low, high;
+
+    // interleaving every value with itself and shifting back sign extends four values per half
+    for (; binCnt+4<=numBins; binCnt+=4)
+    {
+        packed = _mm_loadu_si128((const __m128i *) (filter+2*binCnt));
+        low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+        macBin(sum+2*binCnt, in+2*binCnt, _mm_mul_pd(_mm_cvtepi32_pd(low), scaleVec));
+        macBin(sum+2*binCnt+2, in+2*binCnt+2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(low, low)), scaleVec));
+        macBin(sum+2*binCnt+4, in+2*binCnt+4, _mm_mul_pd(_mm_cvtepi32_pd(high), scaleVec));
+        macBin(sum+2*binCnt+6, in+2*binCnt+6, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(high, high)), scaleVec));
+    }
+#endif
+
+    macInt16Loop(sum+2*binCnt, in+2*binCnt, filter+2*binCnt, scale, numBins-binCnt);
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,270 @@
+/*-----------------------------------------------------------------------------*\
+| Offline rendering of whole signals. The partitioned sum of block n only      |
+| depends on the input spectra of the blocks n, n-2, ..., so the signal is cut |
+| into chunks of blocks and all input FFTs of a chunk, followed by all MACs    |
+| and IFFTs of the chunk, are computed in parallel. Only the overlap add runs  |
+| sequentially. The frequency delay line of the previous chunk is kept in a    |
+| ring, so the memory does not grow with the length of the signal.             |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <thread>
+#include <memory>
+#include "TVOLAP.h"
+#include "ThreadPool.h"
+#include "TVOLAPCache.h"
+
+#define OFFLINE_BLOCKS_PER_THREAD 8
+
+struct TVOLAP::Offline
+{
+    TVOLAP *inst;
+    const double *inInterleaved;
+    const uint32_t *irSchedule;
+    uint32_t numFrames, numBlocks, numProcChans, chunkBeg, chunkLen, numSpecSlots, numIfftSlots;
+    std::vector< std::vector< std::vector<complex_float64> > > spectrum;
+    std::vector< std::vector< std::vector<double> > > ifftBlock;
+    std::vector< std::vector<double> > inBlockWin;
+    std::vector< std::vector<complex_float64> > spectrumSum;
+    // with an IR cache the scheduled IRs are transformed into slots of their own
+    std::vector<const complex_float64 * const *> irParts;
+    std::vector< std::unique_ptr<IRSpectra> > slotSpectra;
+    std::vector<uint32_t> irSlot, slotIR, slotChunk, newSlots;
+    std::vector< std::vector<double> > tmpPartIR;
+
+    static void fftJob(void *context, uint32_t taskIdx, uint32_t threadIdx);
+    static void transformJob(void *context, uint32_t taskIdx, uint32_t threadIdx);
+    static void macJob(void *context, uint32_t taskIdx, uint32_t threadIdx);
+    uint32_t assignSlots(uint32_t chunkIdx);
+};
+
+void TVOLAP::Offline::fftJob(void *context, uint32_t taskIdx, uint32_t threadIdx)
+{
+    Offline &off = *(Offline *) context;
+    TVOLAP &inst = *off.inst;
+    uint32_t chanCnt = taskIdx%off.numProcChans, blockCnt = off.chunkBeg+taskIdx/off.numProcChans;
+    uint32_t sampleCnt;
+    int64_t frameCnt;
+    std::vector<double> &inBlockWin = off.inBlockWin[threadIdx];
+
+    // the process window covers the previous and the actual block
+    for (sampleCnt=0, frameCnt=int64_t(blockCnt)*inst.blockLen-inst.blockLen; sampleCnt<inst.processLen; sampleCnt++, frameCnt++)
+    {
+        if (frameCnt >= 0 && frameCnt < off.numFrames)
+            inBlockWin[sampleCnt] = off.inInterleaved[frameCnt*inst.numChansAudio+chanCnt]*inst.winVec[sampleCnt];
+        else
+            inBlockWin[sampleCnt] = 0.0;
+    }
+
+    rfft_double(inBlockWin.data(), off.spectrum[blockCnt%off.numSpecSlots][chanCnt].data(), inst.nfft);
+}
+
+void TVOLAP::Offline::transformJob(void *context, uint32_t taskIdx, uint32_t threadIdx)
+{
+    Offline &off = *(Offline *) context;
+    uint32_t slotIdx = off.newSlots[taskIdx];
+
+    off.inst->transformBankIR(off.slotIR[slotIdx], off.slotSpectra[slotIdx]->bins.data(), off.tmpPartIR[threadIdx]);
+}
+
+uint32_t TVOLAP::Offline::assignSlots(uint32_t chunkIdx)
+{
+    uint32_t blockCnt, slotIdx, irIdx;
+
+    // the chunk ends before the first IR for which no slot is left besides the IRs of the chunk
+    newSlots.clear();
+    for (blockCnt=chunkBeg; blockCnt<chunkBeg+chunkLen; blockCnt++)
+    {
+        irIdx = irSchedule[blockCnt];
+        if (irSlot[irIdx] == slotIR.size())
+        {
+            for (slotIdx=0; slotIdx<slotIR.size(); slotIdx++)
+            {
+                if (slotChunk[slotIdx] != chunkIdx)
+                    break;
+            }
+            if (slotIdx == slotIR.size())
+                return blockCnt-chunkBeg;
+
+            if (!slotSpectra[slotIdx])
+            {
+                slotSpectra[slotIdx].reset(new IRSpectra);
+                inst->allocSpectra(*slotSpectra[slotIdx], 1);
+            }
+            if (slotIR[slotIdx] < irSlot.size())
+            {
+                irSlot[slotIR[slotIdx]] = uint32_t(slotIR.size());
+                irParts[slotIR[slotIdx]] = NULL;
+            }
+
+            slotIR[slotIdx] = irIdx;
+            irSlot[irIdx] = slotIdx;
+            irParts[irIdx] = slotSpectra[slotIdx]->parts.data();
+            newSlots.push_back(slotIdx);
+        }
+        slotChunk[irSlot[irIdx]] = chunkIdx;
+    }
+
+    return chunkLen;
+}
+
+void TVOLAP::Offline::macJob(void *context, uint32_t taskIdx, uint32_t threadIdx)
+{
+    Offline &off = *(Offline *) context;
+    TVOLAP &inst = *off.inst;
+    uint32_t chanCnt = taskIdx%off.numProcChans, blockCnt = off.chunkBeg+taskIdx/off.numProcChans;
+    uint32_t partCnt, sampleCnt, actIR = off.irSchedule[blockCnt], partOffset = inst.partOffsets[actIR*inst.numChansIR+chanCnt];
+    complex_float64 *sum = off.spectrumSum[threadIdx].data();
+
+    for (sampleCnt=0; sampleCnt<inst.processLen+1; sampleCnt++)
+        sum[sampleCnt].re = sum[sampleCnt].im = 0.0;
+
+    // the private slots of a cached bank are always float64
+    MacKernel mac = off.irParts.empty() ? inst.macKernel : &TVOLAP::macFloat64;
+    const void * const *parts = (off.irParts.empty() ? inst.filterParts(actIR) : (const void * const *) off.irParts[actIR])+chanCnt*inst.numParts;
+
+    // blocks before the start of the signal count as silence
+    for (partCnt=0; partCnt<inst.numParts && (partCnt+partOffset)*inst.overlapFact<=blockCnt; partCnt++)
+        mac(sum, off.spectrum[(blockCnt-(partCnt+partOffset)*inst.overlapFact)%off.numSpecSlots][chanCnt].data(), parts[partCnt], inst.processLen+1);
+
+    irfft_double(sum, off.ifftBlock[blockCnt%off.numIfftSlots][chanCnt].data(), inst.nfft);
+}
+
+int TVOLAP::processOffline(const double *inInterleaved, double *outInterleaved, uint32_t numFrames,
+        const std::vector<uint32_t> &irSchedule, uint32_t numThreads)
+{
+    Offline off;
+    uint32_t threadCnt, slotCnt, chanCnt, blockCnt, sampleCnt, chunkBlocks, chunkCnt;
+    int64_t frameCnt;
+    std::vector< std::vector<double> > convSum, convSumMem;
+
+    // the input of the previous block is read again by the next chunk, so rendering cannot be in place
+    off.numBlocks = (numFrames+blockLen-1)/blockLen;
+    if (irSchedule.size() < off.numBlocks || inInterleaved == outInterleaved)
+        return -1;
+
+    for (blockCnt=0; blockCnt<off.numBlocks; blockCnt++)
+    {
+        if (irSchedule[blockCnt] >= numIR)
+            return -1;
+    }
+
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    chunkBlocks = OFFLINE_BLOCKS_PER_THREAD*numThreads;
+
+    off.inst = this;
+    off.inInterleaved = inInterleaved;
+    off.irSchedule = irSchedule.data();
+    off.numFrames = numFrames;
+    off.numProcChans = std::min(numChansAudio, numChansIR);
+    off.numSpecSlots = chunkBlocks+numMems-1;
+    off.numIfftSlots = chunkBlocks+overlapFact;
+
+    off.spectrum.resize(off.numSpecSlots);
+    for (slotCnt=0; slotCnt<off.numSpecSlots; slotCnt++)
+    {
+        off.spectrum.at(slotCnt).resize(off.numProcChans);
+        for (chanCnt=0; chanCnt<off.numProcChans; chanCnt++)
+            off.spectrum.at(slotCnt).at(chanCnt).resize(processLen+1);
+    }
+
+    off.ifftBlock.resize(off.numIfftSlots);
+    for (slotCnt=0; slotCnt<off.numIfftSlots; slotCnt++)
+    {
+        off.ifftBlock.at(slotCnt).resize(off.numProcChans);
+        for (chanCnt=0; chanCnt<off.numProcChans; chanCnt++)
+            off.ifftBlock.at(slotCnt).at(chanCnt).resize(nfft, 0.0);
+    }
+
+    off.inBlockWin.resize(numThreads);
+    off.spectrumSum.resize(numThreads);
+    for (threadCnt=0; threadCnt<numThreads; threadCnt++)
+    {
+        off.inBlockWin.at(threadCnt).resize(nfft, 0.0);
+        off.spectrumSum.at(threadCnt).resize(processLen+1);
+    }
+
+    // the IR cache of the real time path is not touched, the slots have the same size
+    if (irCache)
+    {
+        off.irParts.resize(numIR, NULL);
+        off.irSlot.resize(numIR, irCache->numSlots);
+        off.slotIR.resize(irCache->numSlots, numIR);
+        off.slotChunk.resize(irCache->numSlots, UINT32_MAX);
+        off.slotSpectra.resize(irCache->numSlots);
+        off.tmpPartIR.resize(numThreads);
+        for (threadCnt=0; threadCnt<numThreads; threadCnt++)
+            off.tmpPartIR.at(threadCnt).resize(nfft, 0.0);
+    }
+
+    convSum.resize(off.numProcChans);
+    convSumMem.resize(off.numProcChans);
+    for (chanCnt=0; chanCnt<off.numProcChans; chanCnt++)
+    {
+        convSum.at(chanCnt).resize(processLen, 0.0);
+        convSumMem.at(chanCnt).resize(blockLen, 0.0);
+    }
+
+    for (frameCnt=0; frameCnt<int64_t(numFrames)*numChansAudio; frameCnt++)
+        outInterleaved[frameCnt] = inInterleaved[frameCnt];
+
+    ThreadPool pool(numThreads);
+
+    for (off.chunkBeg=0, chunkCnt=0; off.chunkBeg<off.numBlocks; off.chunkBeg+=off.chunkLen, chunkCnt++)
+    {
+        off.chunkLen = std::min(chunkBlocks, off.numBlocks-off.chunkBeg);
+
+        if (irCache)
+        {
+            off.chunkLen = off.assignSlots(chunkCnt);
+            pool.run(&Offline::transformJob, &off, uint32_t(off.newSlots.size()));
+        }
+
+        pool.run(&Offline::fftJob, &off, off.chunkLen*off.numProcChans);
+        pool.run(&Offline::macJob, &off, off.chunkLen*off.numProcChans);
+
+        // overlap add of the convolution tails (two blocks back) and of the window halves
+        for (blockCnt=off.chunkBeg; blockCnt<off.chunkBeg+off.chunkLen; blockCnt++)
+        {
+            for (chanCnt=0; chanCnt<off.numProcChans; chanCnt++)
+            {
+                const std::vector<double> &ifftAct = off.ifftBlock[blockCnt%off.numIfftSlots][chanCnt];
+                const std::vector<double> &ifftOld = off.ifftBlock[(blockCnt+off.numIfftSlots-overlapFact)%off.numIfftSlots][chanCnt];
+
+                for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+                    convSum[chanCnt][sampleCnt] = ifftAct[sampleCnt]+(blockCnt >= overlapFact ? ifftOld[sampleCnt+processLen] : 0.0);
+
+                for (sampleCnt=0, frameCnt=int64_t(blockCnt)*blockLen; sampleCnt<blockLen; sampleCnt++, frameCnt++)
+                {
+                    if (frameCnt < numFrames)
+                        outInterleaved[frameCnt*numChansAudio+chanCnt] = convSum[chanCnt][sampleCnt]+convSumMem[chanCnt][sampleCnt];
+                    convSumMem[chanCnt][sampleCnt] = convSum[chanCnt][sampleCnt+blockLen];
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,207 @@
+/*-----------------------------------------------------------------------------*\
+| Pipelined throughput mode of TVOLAP. The calling thread windows and          |
+| transforms block n, a MAC thread accumulates the partitions of block n-1 and |
+| an IFFT thread does the inverse transform and overlap add of block n-2. The  |
+| stages are connected by lock-free single producer / single consumer rings,   |
+| so the output equals the serial output delayed by PIPELINE_DELAY blocks.     |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "TVOLAPPipeline.h"
+
+TVOLAP::Pipeline::Pipeline(uint32_t numChans, uint32_t numMems, uint32_t blockLen, uint32_t processLen, uint32_t nfft)
+    : fftRing(numMems+PIPELINE_DELAY, Spectra()),
+      macRing(PIPELINE_DELAY, std::vector< std::vector<complex_float64> >(numChans, std::vector<complex_float64>(processLen+1))),
+      outRing(PIPELINE_DELAY+1, std::vector< std::vector<double> >(numChans, std::vector<double>(blockLen, 0.0))),
+      inBlockWin(nfft, 0.0),
+      ifftBlock(nfft, 0.0)
+{
+    uint32_t slotCnt, chanCnt, sampleCnt;
+
+    for (slotCnt=0; slotCnt<fftRing.getNumSlots(); slotCnt++)
+    {
+        fftRing.at(slotCnt).chanIR.resize(numChans, 0);
+        fftRing.at(slotCnt).spectrum.resize(numChans);
+        for (chanCnt=0; chanCnt<numChans; chanCnt++)
+        {
+            fftRing.at(slotCnt).spectrum.at(chanCnt).resize(processLen+1);
+            for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
+                fftRing.at(slotCnt).spectrum.at(chanCnt).at(sampleCnt).re = fftRing.at(slotCnt).spectrum.at(chanCnt).at(sampleCnt).im = 0.0;
+        }
+    }
+
+    numInBlocks = 0;
+    convSaveCnt = 0;
+    quit.store(false);
+}
+
+void TVOLAP::startPipeline(int firstCpu)
+{
+    uint32_t numCpus = std::max(std::thread::hardware_concurrency(), 1u);
+
+    pipeline.reset(new Pipeline(std::min(numChansAudio, numChansIR), numMems, blockLen, processLen, nfft));
+    pipeline->macThread = std::thread(&TVOLAP::pipelineMacLoop, this, firstCpu < 0 ? -1 : int((firstCpu+1)%numCpus));
+    pipeline->ifftThread = std::thread(&TVOLAP::pipelineIfftLoop, this, firstCpu < 0 ? -1 : int((firstCpu+2)%numCpus));
+}
+
+void TVOLAP::stopPipeline()
+{
+    if (!pipeline)
+        return;
+
+    pipeline->quit.store(true, std::memory_order_seq_cst);
+    pipeline->fftRing.wakeAll();
+    pipeline->macRing.wakeAll();
+    pipeline->outRing.wakeAll();
+    pipeline->macThread.join();
+    pipeline->ifftThread.join();
+    pipeline.reset();
+}
+
+void TVOLAP::processPipeline()
+{
+    Pipeline &pipe = *pipeline;
+    uint32_t chanCnt, sampleCnt, numProcChans = std::min(numChansAudio, numChansIR);
+
+    if (!pipe.fftRing.waitWritable(pipe.quit))
+        return;
+
+    Pipeline::Spectra &spectra = pipe.fftRing.writeSlot();
+    for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+    {
+        readInput(chanCnt);
+
+        for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+            pipe.inBlockWin[sampleCnt] = inBlock[chanCnt][sampleCnt]*winVec[sampleCnt];
+
+        rfft_double(pipe.inBlockWin.data(), spectra.spectrum[chanCnt].data(), nfft);
+    }
+    std::copy(chanIR.begin(), chanIR.begin()+numProcChans, spectra.chanIR.begin());
+    pipe.fftRing.push();
+
+    if (pipe.numInBlocks < PIPELINE_DELAY)
+    {
+        pipe.numInBlocks++;
+        for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+            writeOutput(chanCnt, NULL);
+        return;
+    }
+
+    if (!pipe.outRing.waitReadable(pipe.quit))
+        return;
+
+    std::vector< std::vector<double> > &out = pipe.outRing.readSlot();
+    for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+        writeOutput(chanCnt, out[chanCnt].data());
+    pipe.outRing.pop();
+}
+
+void TVOLAP::pipelineMacLoop(int cpuIdx)
+{
+    Pipeline &pipe = *pipeline;
+    uint32_t chanCnt, partCnt, sampleCnt, numProcChans = std::min(numChansAudio, numChansIR);
+    uint32_t numSlots = pipe.fftRing.getNumSlots(), macCnt = 0, fdlIdx = 0, fdlFill = 0, readIdx, partOffset;
+    MacKernel mac = macKernel;
+    const void * const *parts;
+
+    if (cpuIdx >= 0)
+        ThreadPool::setThreadAffinity(uint32_t(cpuIdx));
+
+    while (pipe.fftRing.waitReadable(macCnt, pipe.quit) && pipe.macRing.waitWritable(pipe.quit))
+    {
+        std::vector< std::vector<complex_float64> > &spectrumSum = pipe.macRing.writeSlot();
+
+        applyStagedIR();
+
+        std::vector<uint32_t> &blockIR = pipe.fftRing.at(fdlIdx).chanIR;
+        acquireChannelIRs(blockIR);
+        if (fdlFill < numMems)
+            fdlFill++;
+
+        for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+        {
+            complex_float64 *sum = spectrumSum[chanCnt].data();
+
+            for (sampleCnt=0; sampleCnt<processLen+1; sampleCnt++)
+                sum[sampleCnt].re = sum[sampleCnt].im = 0.0;
+
+            // blocks before the start of the pipeline count as silence
+            partOffset = partOffsets[blockIR[chanCnt]*numChansIR+chanCnt];
+            readIdx = (fdlIdx+numSlots-(partOffset*overlapFact)%numSlots)%numSlots;
+            parts = filterParts(blockIR[chanCnt])+chanCnt*numParts;
+            for (partCnt=0; partCnt<numParts && (partCnt+partOffset)*overlapFact<fdlFill; partCnt++)
+            {
+                mac(sum, pipe.fftRing.at(readIdx).spectrum[chanCnt].data(), parts[partCnt], processLen+1);
+                readIdx = (readIdx+numSlots-overlapFact)%numSlots;
+            }
+        }
+
+        pipe.macRing.push();
+
+        macCnt++;
+        if (++fdlIdx >= numSlots)
+            fdlIdx = 0;
+
+        // the oldest block is not needed by the next MAC any more
+        if (fdlFill == numMems)
+            pipe.fftRing.pop();
+    }
+}
+
+void TVOLAP::pipelineIfftLoop(int cpuIdx)
+{
+    Pipeline &pipe = *pipeline;
+    uint32_t chanCnt, sampleCnt, numProcChans = std::min(numChansAudio, numChansIR);
+
+    if (cpuIdx >= 0)
+        ThreadPool::setThreadAffinity(uint32_t(cpuIdx));
+
+    while (pipe.macRing.waitReadable(pipe.quit) && pipe.outRing.waitWritable(pipe.quit))
+    {
+        std::vector< std::vector<complex_float64> > &spectrumSum = pipe.macRing.readSlot();
+        std::vector< std::vector<double> > &out = pipe.outRing.writeSlot();
+
+        for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+        {
+            irfft_double(spectrumSum[chanCnt].data(), pipe.ifftBlock.data(), nfft);
+
+            for (sampleCnt=0; sampleCnt<processLen; sampleCnt++)
+            {
+                outBlock[chanCnt][sampleCnt] = pipe.ifftBlock[sampleCnt]+convMem[chanCnt][pipe.convSaveCnt][sampleCnt];
+                convMem[chanCnt][pipe.convSaveCnt][sampleCnt] = pipe.ifftBlock[sampleCnt+processLen];
+            }
+
+            for (sampleCnt=0; sampleCnt<blockLen; sampleCnt++)
+            {
+                out[chanCnt][sampleCnt] = outBlock[chanCnt][sampleCnt]+outBlockMem[chanCnt][sampleCnt];
+                outBlockMem[chanCnt][sampleCnt] = outBlock[chanCnt][sampleCnt+blockLen];
+            }
+        }
+
+        pipe.macRing.pop();
+        pipe.outRing.push();
+
+        if (++pipe.convSaveCnt >= overlapFact)
+            pipe.convSaveCnt = 0;
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
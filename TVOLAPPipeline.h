@@ -0,0 +1,58 @@
+/*-----------------------------------------------------------------------------*\
+| Private header of TVOLAPPipeline.cpp, only included by the TVOLAP sources.    |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef TVOLAPPIPELINE_H
+#define TVOLAPPIPELINE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "TVOLAP.h"
+#include "SPSCRing.h"
+
+// blocks between the input of a block and its output in pipeline mode
+#define PIPELINE_DELAY 2
+
+struct TVOLAP::Pipeline
+{
+    struct Spectra
+    {
+        std::vector< std::vector<complex_float64> > spectrum;
+        std::vector<uint32_t> chanIR;
+    };
+
+    Pipeline(uint32_t numChans, uint32_t numMems, uint32_t blockLen, uint32_t processLen, uint32_t nfft);
+
+    // the input spectra ring is the frequency delay line of the MAC stage at the same time
+    SPSCRing<Spectra> fftRing;
+    SPSCRing< std::vector< std::vector<complex_float64> > > macRing;
+    SPSCRing< std::vector< std::vector<double> > > outRing;
+    std::vector<double> inBlockWin, ifftBlock;
+    uint32_t numInBlocks, convSaveCnt;
+    std::atomic<bool> quit;
+    std::thread macThread, ifftThread;
+};
+
+#endif // TVOLAPPIPELINE_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
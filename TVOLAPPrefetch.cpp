@@ -0,0 +1,241 @@
+/*-----------------------------------------------------------------------------*\
+| Prefetch of predicted IRs into the IR cache. After every block the reading    |
+| thread predicts the next IRs of each channel, either by continuing its last   |
+| IR change (e.g. a walk through the index range of a horizontal HRIR set) or,  |
+| if the caller reports the motion of the sources, by moving along the          |
+| positions of the IRs. Missing ones are requested from a background thread,    |
+| which transforms them into spare spectra buffers. At the start of a later     |
+| block the finished buffers are exchanged with the least recently used cache   |
+| slots, so the block that switches to a predicted IR finds it resident and     |
+| costs no more than a steady block. All hand overs run through wait-free       |
+| single producer / single consumer rings, the reading thread never waits for   |
+| the prefetch thread.                                                          |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "TVOLAPCache.h"
+
+int TVOLAP::setPrefetch(uint32_t numAhead, int cpuIdx)
+{
+    uint32_t slotCnt, bufCnt, numProcChans = std::min(numChansAudio, numChansIR);
+    std::vector<Prefetch::Buffer> freeBuffers;
+    Prefetch::Buffer buf;
+
+    if (!irCache)
+        return -1;
+
+    stopPrefetch();
+    if (numAhead == 0 && irCache->missMode != MISS_DEFER)
+        return 0;
+
+    // every allocated buffer that is not used by a cache slot is free, the spare ones are never freed
+    // because a cache slot may have taken one in exchange for its own
+    buf.irIdx = 0;
+    buf.storage = NULL;
+    for (bufCnt=0; bufCnt<irCache->numSlots+prefetchSpectra.size() || freeBuffers.size() < std::max(numAhead, 1u); bufCnt++)
+    {
+        if (bufCnt >= irCache->numSlots+prefetchSpectra.size())
+        {
+            prefetchSpectra.push_back(std::unique_ptr<IRSpectra>(new IRSpectra));
+            allocSpectra(*prefetchSpectra.back(), 1);
+        }
+
+        IRSpectra *spectra = bufCnt < irCache->numSlots ? irCache->slotStorage.at(bufCnt).get() : prefetchSpectra.at(bufCnt-irCache->numSlots).get();
+        if (spectra == NULL)
+            continue;
+
+        for (slotCnt=0; slotCnt<irCache->numSlots && irCache->slotBins.at(slotCnt) != spectra->bins.data(); slotCnt++);
+        if (slotCnt < irCache->numSlots)
+            continue;
+
+        buf.bins = spectra->bins.data();
+        buf.parts = spectra->parts.data();
+        freeBuffers.push_back(buf);
+    }
+
+    prefetch.reset(new Prefetch(uint32_t(freeBuffers.size()), std::max(numAhead, 1u)*numProcChans));
+    prefetch->numAhead = numAhead;
+    prefetch->cpuIdx = cpuIdx;
+    prefetch->lastIR.assign(chanIR.begin(), chanIR.begin()+numProcChans);
+    prefetch->lastStep.resize(numProcChans, 0);
+    prefetch->irPending.resize(numIR, false);
+    prefetch->tmpPartIR.resize(nfft);
+    prefetch->quit.store(false);
+
+    for (bufCnt=0; bufCnt<freeBuffers.size(); bufCnt++)
+    {
+        prefetch->freeBuffers.writeSlot() = freeBuffers.at(bufCnt);
+        prefetch->freeBuffers.push();
+    }
+
+    prefetch->worker = std::thread(&TVOLAP::prefetchLoop, this, cpuIdx);
+
+    return 0;
+}
+
+int TVOLAP::setMotion(double azimuthStep, double elevationStep)
+{
+    if (dirIndex.getNumPositions() == 0)
+        return -1;
+
+    motionAzStep.store(azimuthStep, std::memory_order_relaxed);
+    motionElStep.store(elevationStep, std::memory_order_relaxed);
+    hasMotion.store(true, std::memory_order_release);
+
+    return 0;
+}
+
+void TVOLAP::stopPrefetch()
+{
+    if (!prefetch)
+        return;
+
+    // finished but not adopted buffers are found free again by the next setPrefetch()
+    prefetch->quit.store(true, std::memory_order_seq_cst);
+    prefetch->requests.wakeAll();
+    prefetch->freeBuffers.wakeAll();
+    prefetch->worker.join();
+    prefetch.reset();
+}
+
+void TVOLAP::adoptPrefetched()
+{
+    IRCache &cache = *irCache;
+    Prefetch &pf = *prefetch;
+    complex_float64 *bins;
+    const complex_float64 * const *parts;
+    uint32_t victim;
+
+    while (pf.doneBuffers.isReadable())
+    {
+        Prefetch::Buffer buf = pf.doneBuffers.readSlot();
+        pf.doneBuffers.pop();
+        pf.irPending[buf.irIdx] = false;
+
+        // slots used by the last block are pinned, a late prediction is dropped instead
+        if (irParts[buf.irIdx] == NULL && (victim = evictCacheSlot(cache.useCnt)) < cache.numSlots)
+        {
+            bins = cache.slotBins[victim];
+            parts = cache.slotParts[victim];
+            cache.slotBins[victim] = buf.bins;
+            cache.slotParts[victim] = buf.parts;
+            cache.slotIR[victim] = buf.irIdx;
+            cache.slotUse[victim] = cache.useCnt;
+            cache.irSlot[buf.irIdx] = victim;
+            irParts[buf.irIdx] = buf.parts;
+            cache.numPrefetches.fetch_add(1, std::memory_order_relaxed);
+            buf.bins = bins;
+            buf.parts = parts;
+            buf.storage = bins == NULL ? &cache.slotStorage[victim] : NULL;
+        }
+
+        pf.freeBuffers.writeSlot() = buf;
+        pf.freeBuffers.push();
+    }
+}
+
+void TVOLAP::requestPrefetch(const std::vector<uint32_t> &procIR)
+{
+    Prefetch &pf = *prefetch;
+    uint32_t chanCnt, aheadCnt, predIR, numProcChans = std::min(numChansAudio, numChansIR);
+    double azimuth = 0.0, elevation = 0.0, distance = 0.0, azStep = 0.0, elStep = 0.0;
+    int64_t nextIR;
+    bool useMotion = hasMotion.load(std::memory_order_acquire);
+
+    if (useMotion)
+    {
+        azStep = motionAzStep.load(std::memory_order_relaxed);
+        elStep = motionElStep.load(std::memory_order_relaxed);
+    }
+
+    for (chanCnt=0; chanCnt<numProcChans; chanCnt++)
+    {
+        if (procIR[chanCnt] != pf.lastIR[chanCnt])
+        {
+            pf.lastStep[chanCnt] = int64_t(procIR[chanCnt])-int64_t(pf.lastIR[chanCnt]);
+            pf.lastIR[chanCnt] = procIR[chanCnt];
+        }
+
+        if (useMotion)
+            dirIndex.getPosition(procIR[chanCnt], azimuth, elevation, distance);
+
+        for (aheadCnt=1; aheadCnt<=pf.numAhead; aheadCnt++)
+        {
+            if (useMotion)
+                predIR = dirIndex.findNearest(azimuth+aheadCnt*azStep, elevation+aheadCnt*elStep, distance, numIR, 0.0);
+            else
+            {
+                nextIR = int64_t(procIR[chanCnt])+int64_t(aheadCnt)*pf.lastStep[chanCnt];
+                if (pf.lastStep[chanCnt] == 0 || nextIR < 0 || nextIR >= numIR)
+                    break;
+                predIR = uint32_t(nextIR);
+            }
+
+            requestIR(predIR);
+        }
+    }
+}
+
+void TVOLAP::requestIR(uint32_t irIdx)
+{
+    Prefetch &pf = *prefetch;
+
+    // a full request ring drops the request, it is repeated by a later block
+    if (irParts[irIdx] == NULL && !pf.irPending[irIdx] && pf.requests.isWritable())
+    {
+        pf.requests.writeSlot() = irIdx;
+        pf.requests.push();
+        pf.irPending[irIdx] = true;
+    }
+}
+
+void TVOLAP::prefetchLoop(int cpuIdx)
+{
+    Prefetch &pf = *prefetch;
+
+    if (cpuIdx >= 0)
+        ThreadPool::setThreadAffinity(uint32_t(cpuIdx));
+
+    while (pf.requests.waitReadable(pf.quit) && pf.freeBuffers.waitReadable(pf.quit))
+    {
+        Prefetch::Buffer buf = pf.freeBuffers.readSlot();
+        buf.irIdx = pf.requests.readSlot();
+        pf.freeBuffers.pop();
+        pf.requests.pop();
+
+        // the slot that took a buffer without storage of its own gets it allocated here
+        if (buf.bins == NULL)
+        {
+            buf.storage->reset(new IRSpectra);
+            allocSpectra(**buf.storage, 1);
+            buf.bins = (*buf.storage)->bins.data();
+            buf.parts = (*buf.storage)->parts.data();
+            buf.storage = NULL;
+        }
+
+        transformBankIR(buf.irIdx, buf.bins, pf.tmpPartIR);
+
+        pf.doneBuffers.writeSlot() = buf;
+        pf.doneBuffers.push();
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
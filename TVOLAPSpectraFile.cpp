@@ -0,0 +1,157 @@
+/*-----------------------------------------------------------------------------*\
+| Precomputed filter spectra. saveFilterSpectra() writes the partitioned and    |
+| transformed IRs of an instance to a versioned file, the FilterBank taking     |
+| such a file maps it and uses the spectra in place, so a restart costs no FFT. |
+| The 64 byte header is tagged with block length, FFT size, precision and       |
+| layout and is checked before anything is used. File layout: header, then      |
+| numIR*numChansIR*numParts spectra of processLen+1 complex float64 bins,       |
+| ordered IR, channel, partition, in the byte order of the generating machine.  |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <stdexcept>
+#include <cstring>
+#include <fstream>
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "TVOLAPAsync.h"
+#include "TVOLAPCache.h"
+#include "TVOLAPEvents.h"
+#include "TVOLAPPipeline.h"
+
+#define SPECTRA_FILE_MAGIC "TVOLAPFS"
+#define SPECTRA_FILE_VERSION 1
+#define SPECTRA_FILE_BYTE_ORDER 0x01020304
+#define SPECTRA_FILE_PRECISION_FLOAT64 8
+#define SPECTRA_FILE_LAYOUT_IR_CHAN_PART 0
+
+struct SpectraFileHeader
+{
+    char magic[8];
+    uint32_t version, headerSize, byteOrder, precision, layout;
+    uint32_t blockLen, nfft, numIR, numChansIR, lenIR, numParts;
+    uint32_t reserved[3];
+};
+
+FilterBank::FilterBank(const char *spectraFile)
+{
+    SpectraFileHeader header;
+    uint32_t partCnt;
+
+    file.reset(new MappedFile);
+    if (file->open(spectraFile) < 0)
+        throw std::runtime_error("Filter spectra file cannot be mapped.");
+
+    if (file->getSize() < sizeof(header))
+        throw std::runtime_error("Filter spectra file is too short.");
+
+    memcpy(&header, file->getData(), sizeof(header));
+    if (memcmp(header.magic, SPECTRA_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != SPECTRA_FILE_VERSION ||
+            header.headerSize != sizeof(header) || header.byteOrder != SPECTRA_FILE_BYTE_ORDER)
+        throw std::runtime_error("File is no filter spectra file of this version and byte order.");
+
+    if (header.precision != SPECTRA_FILE_PRECISION_FLOAT64 || header.layout != SPECTRA_FILE_LAYOUT_IR_CHAN_PART)
+        throw std::runtime_error("Precision or layout of the filter spectra file is not supported.");
+
+    if (header.blockLen == 0 || header.nfft != 4*header.blockLen || header.numParts == 0 ||
+            (header.lenIR-1)/(2*header.blockLen)+1 != header.numParts)
+        throw std::runtime_error("Dimensions in the filter spectra file are inconsistent.");
+
+    init(header.numIR, header.lenIR, header.numChansIR, header.blockLen);
+
+    if (file->getSize() < sizeof(header)+uint64_t(numIR)*numChansIR*numParts*(processLen+1)*sizeof(complex_float64))
+        throw std::runtime_error("Filter spectra file is too short.");
+
+    // zero copy, only the table of partition pointers is allocated
+    const complex_float64 *fileBins = (const complex_float64 *) ((const char *) file->getData()+sizeof(header));
+    parts.resize(numIR*numChansIR*numParts);
+    for (partCnt=0; partCnt<numIR*numChansIR*numParts; partCnt++)
+        parts.at(partCnt) = fileBins+uint64_t(partCnt)*(processLen+1);
+    numUniqueParts = numIR*numChansIR*numParts;
+}
+
+TVOLAP::TVOLAP(const char *spectraFile, uint32_t blockLen, uint32_t numChansAudio)
+{
+    filterBank.reset(new FilterBank(spectraFile));
+    if (filterBank->getBlockLen() != blockLen)
+        throw std::runtime_error("Filter spectra file was generated for another block length.");
+
+    init(filterBank->getNumIR(), filterBank->getLenIR(), filterBank->getNumChansIR(), blockLen, numChansAudio);
+}
+
+int TVOLAP::saveFilterSpectra(const char *fileName)
+{
+    SpectraFileHeader header;
+    IRSpectra tmpSpectra;
+    std::vector<double> tmpPartIR;
+    const complex_float64 * const *parts;
+    uint32_t irCnt, partCnt;
+
+    // the file holds neither delays nor reduced precision spectra
+    if (maxPartOffset > 0 || precision != FilterBank::PRECISION_FLOAT64)
+        return -1;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SPECTRA_FILE_MAGIC, sizeof(header.magic));
+    header.version = SPECTRA_FILE_VERSION;
+    header.headerSize = sizeof(header);
+    header.byteOrder = SPECTRA_FILE_BYTE_ORDER;
+    header.precision = SPECTRA_FILE_PRECISION_FLOAT64;
+    header.layout = SPECTRA_FILE_LAYOUT_IR_CHAN_PART;
+    header.blockLen = blockLen;
+    header.nfft = nfft;
+    header.numIR = numIR;
+    header.numChansIR = numChansIR;
+    header.lenIR = numParts*processLen;
+    header.numParts = numParts;
+
+    std::ofstream outFile(fileName, std::ios::out | std::ios::binary);
+    if (!outFile.is_open())
+        return -1;
+
+    outFile.write((const char *) &header, sizeof(header));
+
+    // IRs of a cached bank that are not resident are transformed into a buffer of their own, so the
+    // export leaves the cache as it is
+    if (irCache)
+    {
+        allocSpectra(tmpSpectra, 1);
+        tmpPartIR.resize(nfft, 0.0);
+    }
+
+    for (irCnt=0; irCnt<numIR; irCnt++)
+    {
+        parts = irParts[irCnt];
+        if (parts == NULL)
+        {
+            transformBankIR(irCnt, tmpSpectra.bins.data(), tmpPartIR);
+            parts = tmpSpectra.parts.data();
+        }
+
+        for (partCnt=0; partCnt<numChansIR*numParts; partCnt++)
+            outFile.write((const char *) parts[partCnt], (processLen+1)*sizeof(complex_float64));
+    }
+
+    outFile.close();
+
+    return outFile.good() ? 0 : -1;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
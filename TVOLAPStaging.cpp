@@ -0,0 +1,228 @@
+/*-----------------------------------------------------------------------------*\
+| Runtime replacement of impulse responses. stageIR() partitions and            |
+| transforms a new IR on the calling thread into a private set of spectra,      |
+| publishIR() marks it as ready and the thread that reads the spectra swaps     |
+| the pointer table of the IR at the next block boundary. The spectra that      |
+| were replaced are kept until the next stageIR() / reclaimIR(), so they are    |
+| never freed while a MAC might still read them (read copy update).             |
+| stageIRs() stages a batch of IRs from a shared filter bank, transformed once  |
+| for all instances that use it, and swaps the whole batch in one block.        |
+| loadIR() does the same without a second thread: the transforms are spread     |
+| over several process() calls, a bounded number of partitions per block.       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "TVOLAP.h"
+
+int TVOLAP::stageIR(uint32_t irIdx, const std::vector<double> &irSamples)
+{
+    std::vector<double> tmpPartIR(nfft);
+    uint32_t lenIR, chanCnt, partCnt, partBeg;
+
+    // the spectra of a filter bank in reduced precision cannot be mixed with transformed ones
+    if (irIdx >= numIR || irSamples.size()%numChansIR != 0 || precision != FilterBank::PRECISION_FLOAT64)
+        return -1;
+
+    lenIR = uint32_t(irSamples.size()/numChansIR);
+    if (lenIR == 0 || lenIR > numParts*processLen)
+        return -1;
+
+    if (reclaimIR() < 0)
+        return -1;
+
+    stagedIR.reset(new IRSpectra);
+    allocSpectra(*stagedIR, 1);
+    retiredIRs.resize(1);
+    retiredBanks.resize(1);
+
+    for (chanCnt=0; chanCnt<numChansIR; chanCnt++)
+    {
+        for (partCnt=0; partCnt<numParts; partCnt++)
+        {
+            partBeg = std::min(partCnt*processLen, lenIR);
+            FilterBank::transformPartition(irSamples.data()+chanCnt*lenIR+partBeg, std::min(processLen, lenIR-partBeg),
+                    &stagedIR->bins.at((chanCnt*numParts+partCnt)*(processLen+1)), tmpPartIR);
+        }
+    }
+
+    stagedIdx = irIdx;
+    stageState.store(STAGE_STAGED, std::memory_order_release);
+
+    return 0;
+}
+
+int TVOLAP::stageIRs(const std::vector<uint32_t> &irIdx, std::shared_ptr<const FilterBank> bank)
+{
+    uint32_t irCnt;
+
+    if (!bank || precision != FilterBank::PRECISION_FLOAT64 || bank->getPrecision() != FilterBank::PRECISION_FLOAT64)
+        return -1;
+
+    if (bank->getBlockLen() != blockLen || bank->getNumChansIR() != numChansIR || bank->getLenIR() != numParts*processLen)
+        return -1;
+
+    if (irIdx.empty() || irIdx.size() != bank->getNumIR())
+        return -1;
+
+    for (irCnt=0; irCnt<irIdx.size(); irCnt++)
+    {
+        if (irIdx[irCnt] >= numIR)
+            return -1;
+    }
+
+    if (reclaimIR() < 0)
+        return -1;
+
+    // the swap only exchanges pointers, the slots for the replaced spectra are allocated here
+    stagedBatch = irIdx;
+    stagedBank = bank;
+    retiredIRs.resize(irIdx.size());
+    retiredBanks.resize(irIdx.size());
+
+    stageState.store(STAGE_STAGED, std::memory_order_release);
+
+    return 0;
+}
+
+int TVOLAP::publishIR()
+{
+    uint32_t expected = STAGE_STAGED;
+
+    if (!stageState.compare_exchange_strong(expected, STAGE_PUBLISHED, std::memory_order_acq_rel))
+        return -1;
+
+    return 0;
+}
+
+int TVOLAP::reclaimIR()
+{
+    uint32_t state = stageState.load(std::memory_order_acquire);
+
+    // the reader has not taken the published spectra yet
+    if (state == STAGE_PUBLISHED || state == STAGE_LOADING)
+        return -1;
+
+    // the replaced spectra are unreachable after the swap
+    retiredIRs.clear();
+    retiredBanks.clear();
+    stagedIR.reset();
+    stagedBank.reset();
+    stagedBatch.clear();
+    stageState.store(STAGE_IDLE, std::memory_order_relaxed);
+
+    return 0;
+}
+
+int TVOLAP::loadIR(uint32_t irIdx, const std::vector<double> &irSamples, uint32_t numPartsPerBlock)
+{
+    if (irIdx >= numIR || irSamples.size()%numChansIR != 0 || numPartsPerBlock == 0 || precision != FilterBank::PRECISION_FLOAT64)
+        return -1;
+
+    if (irSamples.size()/numChansIR == 0 || irSamples.size()/numChansIR > numParts*processLen)
+        return -1;
+
+    if (reclaimIR() < 0)
+        return -1;
+
+    stagedIR.reset(new IRSpectra);
+    allocSpectra(*stagedIR, 1);
+    retiredIRs.resize(1);
+    retiredBanks.resize(1);
+    loadSamples = irSamples;
+    loadLenIR = uint32_t(irSamples.size()/numChansIR);
+    loadPartIR.resize(nfft);
+    loadPartsPerBlock = numPartsPerBlock;
+    loadPartCnt.store(0, std::memory_order_relaxed);
+
+    stagedIdx = irIdx;
+    stageState.store(STAGE_LOADING, std::memory_order_release);
+
+    return 0;
+}
+
+double TVOLAP::getLoadProgress() const
+{
+    uint32_t state = stageState.load(std::memory_order_acquire);
+
+    if (state == STAGE_LOADING)
+        return double(loadPartCnt.load(std::memory_order_relaxed))/double(numChansIR*numParts);
+    else if (state == STAGE_STAGED || state == STAGE_PUBLISHED)
+        return 0.0;
+
+    return 1.0;
+}
+
+bool TVOLAP::loadPartitions()
+{
+    uint32_t partCnt = loadPartCnt.load(std::memory_order_relaxed), partEnd, partBeg, chanCnt;
+
+    partEnd = std::min(partCnt+loadPartsPerBlock, numChansIR*numParts);
+    for (; partCnt<partEnd; partCnt++)
+    {
+        chanCnt = partCnt/numParts;
+        partBeg = std::min((partCnt%numParts)*processLen, loadLenIR);
+        FilterBank::transformPartition(loadSamples.data()+chanCnt*loadLenIR+partBeg, std::min(processLen, loadLenIR-partBeg),
+                &stagedIR->bins[partCnt*(processLen+1)], loadPartIR);
+    }
+
+    loadPartCnt.store(partCnt, std::memory_order_relaxed);
+
+    return partCnt == numChansIR*numParts;
+}
+
+void TVOLAP::applyStagedIR()
+{
+    uint32_t state = stageState.load(std::memory_order_acquire), irCnt, irIdx;
+
+    if (state == STAGE_LOADING)
+    {
+        if (!loadPartitions())
+            return;
+    }
+    else if (state != STAGE_PUBLISHED)
+        return;
+
+    // nothing is freed here, the staging thread reclaims the replaced spectra
+    if (stagedBank)
+    {
+        for (irCnt=0; irCnt<stagedBatch.size(); irCnt++)
+        {
+            irIdx = stagedBatch[irCnt];
+            irParts[irIdx] = stagedBank->getParts(irCnt);
+            retiredIRs[irCnt].swap(irLoaded[irIdx]);
+            retiredBanks[irCnt].swap(irShared[irIdx]);
+            irShared[irIdx] = stagedBank;
+            irVersion[irIdx].fetch_add(1, std::memory_order_release);
+        }
+    }
+    else
+    {
+        irParts[stagedIdx] = stagedIR->parts.data();
+        retiredIRs[0].swap(irLoaded[stagedIdx]);
+        retiredBanks[0].swap(irShared[stagedIdx]);
+        irLoaded[stagedIdx].swap(stagedIR);
+        irVersion[stagedIdx].fetch_add(1, std::memory_order_release);
+    }
+
+    stageState.store(STAGE_SWAPPED, std::memory_order_release);
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
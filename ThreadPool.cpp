@@ -0,0 +1,202 @@
+/*-----------------------------------------------------------------------------*\
+| Persistent worker pool for the real time processing routines. The calling     |
+| thread takes part in every run as thread 0, the workers are numbered from 1   |
+| to numThreads-1. A run is started by incrementing the generation counter,     |
+| tasks are fetched by an atomic counter and the caller returns as soon as all  |
+| workers have reported back. No memory is allocated and no lock is taken       |
+| after construction. Idle workers spin on the generation counter for a short   |
+| while and then park on it (futex on Linux), so the caller only pays for a     |
+| wake-up system call if a worker actually went to sleep.                       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <stdexcept>
+#include <algorithm>
+#include "ThreadPool.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#define SPIN_CNT_BEFORE_YIELD 4096
+#define SPIN_CNT_BEFORE_SLEEP 65536
+
+void ThreadPool::futexWait(std::atomic<uint32_t> &value, uint32_t oldValue)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&value), FUTEX_WAIT_PRIVATE, oldValue, NULL, NULL, 0);
+#else
+    while (value.load(std::memory_order_acquire) == oldValue)
+        std::this_thread::yield();
+#endif
+}
+
+void ThreadPool::futexWake(std::atomic<uint32_t> &value)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&value), FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#else
+    (void) value;
+#endif
+}
+
+int ThreadPool::setThreadAffinity(uint32_t cpuIdx)
+{
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+
+    if (cpuIdx >= CPU_SETSIZE)
+        return -1;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpuIdx, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0 ? 0 : -1;
+#elif defined(_WIN32)
+    // the mask only covers the first processor group
+    if (cpuIdx >= 8*sizeof(DWORD_PTR))
+        return -1;
+
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpuIdx) != 0 ? 0 : -1;
+#else
+    (void) cpuIdx;
+    return -1;
+#endif
+}
+
+ThreadPool::ThreadPool(uint32_t numThreads, int firstCpu)
+{
+    uint32_t threadCnt, numCpus = std::max(std::thread::hardware_concurrency(), 1u);
+
+    if (numThreads < 1)
+        throw std::runtime_error("Number of threads must be at least one.");
+
+    this->numThreads = numThreads;
+    this->numTasks = 0;
+    this->job = NULL;
+    this->context = NULL;
+    generation.store(0);
+    nextTask.store(0);
+    doneWorkers.store(0);
+    sleepingWorkers.store(0);
+    quit.store(false);
+
+    workers.reserve(numThreads-1);
+    for (threadCnt=1; threadCnt<numThreads; threadCnt++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, threadCnt,
+                firstCpu < 0 ? -1 : int((firstCpu+threadCnt)%numCpus)));
+}
+
+ThreadPool::~ThreadPool()
+{
+    uint32_t threadCnt;
+
+    quit.store(true, std::memory_order_release);
+    generation.fetch_add(1, std::memory_order_seq_cst);
+    futexWake(generation);
+
+    for (threadCnt=0; threadCnt<workers.size(); threadCnt++)
+        workers[threadCnt].join();
+}
+
+void ThreadPool::run(ThreadPoolJob job, void *context, uint32_t numTasks)
+{
+    uint32_t taskCnt, spinCnt = 0;
+
+    if (workers.empty() || numTasks < 2)
+    {
+        for (taskCnt=0; taskCnt<numTasks; taskCnt++)
+            job(context, taskCnt, 0);
+        return;
+    }
+
+    this->job = job;
+    this->context = context;
+    this->numTasks = numTasks;
+    nextTask.store(0, std::memory_order_relaxed);
+    doneWorkers.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_seq_cst);
+
+    if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+        futexWake(generation);
+
+    runTasks(0);
+
+    while (doneWorkers.load(std::memory_order_acquire) < workers.size())
+    {
+        if (++spinCnt >= SPIN_CNT_BEFORE_YIELD)
+        {
+            std::this_thread::yield();
+            spinCnt = 0;
+        }
+    }
+}
+
+void ThreadPool::runTasks(uint32_t threadIdx)
+{
+    uint32_t taskIdx;
+
+    while ((taskIdx = nextTask.fetch_add(1, std::memory_order_relaxed)) < numTasks)
+        job(context, taskIdx, threadIdx);
+}
+
+void ThreadPool::workerLoop(uint32_t threadIdx, int cpuIdx)
+{
+    uint32_t actGeneration = 0, spinCnt = 0;
+
+    if (cpuIdx >= 0)
+        setThreadAffinity(uint32_t(cpuIdx));
+
+    while (true)
+    {
+        if (generation.load(std::memory_order_acquire) == actGeneration)
+        {
+            spinCnt++;
+            if (spinCnt >= SPIN_CNT_BEFORE_SLEEP)
+            {
+                // the waker reads sleepingWorkers after incrementing the generation,
+                // futexWait returns immediately if the generation changed meanwhile
+                sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+                futexWait(generation, actGeneration);
+                sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+                spinCnt = 0;
+            }
+            else if (spinCnt%SPIN_CNT_BEFORE_YIELD == 0)
+                std::this_thread::yield();
+            continue;
+        }
+
+        actGeneration = generation.load(std::memory_order_acquire);
+        spinCnt = 0;
+
+        if (quit.load(std::memory_order_acquire))
+            break;
+
+        runTasks(threadIdx);
+        doneWorkers.fetch_add(1, std::memory_order_release);
+    }
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,71 @@
+/*-----------------------------------------------------------------------------*\
+| Header of ThreadPool.cpp, for explanation see cpp-file.                       |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+typedef void (*ThreadPoolJob)(void *context, uint32_t taskIdx, uint32_t threadIdx);
+
+class ThreadPool
+{
+
+public:
+    ThreadPool(uint32_t numThreads, int firstCpu = -1);
+    ~ThreadPool();
+
+    void run(ThreadPoolJob job, void *context, uint32_t numTasks);
+
+    // block while value equals oldValue (futex on Linux, yield loop elsewhere) and wake all waiters
+    static void futexWait(std::atomic<uint32_t> &value, uint32_t oldValue);
+    static void futexWake(std::atomic<uint32_t> &value);
+
+    // pin the calling thread to one cpu, returns -1 if not supported or cpuIdx is out of range
+    static int setThreadAffinity(uint32_t cpuIdx);
+
+    inline uint32_t getNumThreads() const
+    {
+        return numThreads;
+    }
+
+private:
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void workerLoop(uint32_t threadIdx, int cpuIdx);
+    void runTasks(uint32_t threadIdx);
+
+    uint32_t numThreads, numTasks;
+    ThreadPoolJob job;
+    void *context;
+    std::atomic<uint32_t> generation, nextTask, doneWorkers, sleepingWorkers;
+    std::atomic<bool> quit;
+    std::vector<std::thread> workers;
+};
+
+#endif // THREADPOOL_H
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
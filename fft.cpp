@@ -33,6 +33,8 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <atomic>
+#include <mutex>
 
 #include "fft.h"
 
@@ -42,7 +44,11 @@ typedef struct {
     double *cos_half;
 } fft_table;
 
-static fft_table table;
+// a table is never changed or freed after it is published, set_twiddle_table() only
+// replaces it by a larger one, so transforms running on other threads keep a valid table
+static fft_table empty_table = {0, NULL, NULL};
+static std::atomic<const fft_table *> table(&empty_table);
+static std::mutex table_mutex;
 
 #ifndef M_PI
 #define M_PI    3.14159265358979323846
@@ -57,6 +63,7 @@ static fft_table table;
 void set_twiddle_table(int max_nfft)
 {
     int i;
+    fft_table *new_table;
 
     if (ilog2(max_nfft) == 0)
     {
@@ -64,60 +71,69 @@ void set_twiddle_table(int max_nfft)
         return;
     }
 
-    // real FFT by half-length complex FFT
-    table.nfft = max_nfft / 2;
+    std::lock_guard<std::mutex> lock(table_mutex);
+
+    // the actual table also serves smaller sizes by a stride
+    if (table.load(std::memory_order_acquire)->nfft >= max_nfft / 2)
+        return;
 
-    if (table.twiddle_factor)
-        free(table.twiddle_factor);
-    table.twiddle_factor = (complex_float64 *) malloc(table.nfft/2*sizeof(complex_float64));
-    if (table.twiddle_factor == NULL)
+    new_table = (fft_table *) malloc(sizeof(fft_table));
+    if (new_table == NULL)
     {
         printf("Error: Insufficient memory.\n");
         return;
     }
 
-    // compute exp(-jw) table for complex fft core
-    for (i=0; i<table.nfft/2; i++)
-    {
-        table.twiddle_factor[i].re = +cos(2. * M_PI * i / table.nfft);
-        table.twiddle_factor[i].im = -sin(2. * M_PI * i / table.nfft);
-    }
+    // real FFT by half-length complex FFT
+    new_table->nfft = max_nfft / 2;
 
-    if (table.cos_half)
-        free(table.cos_half);
-    table.cos_half = (double *) malloc(table.nfft/2*sizeof(double));
-    if (table.cos_half == NULL)
+    new_table->twiddle_factor = (complex_float64 *) malloc(new_table->nfft/2*sizeof(complex_float64));
+    new_table->cos_half = (double *) malloc(new_table->nfft/2*sizeof(double));
+    if (new_table->twiddle_factor == NULL || new_table->cos_half == NULL)
     {
         printf("Error: Insufficient memory.\n");
+        free(new_table->twiddle_factor);
+        free(new_table->cos_half);
+        free(new_table);
         return;
     }
 
+    // compute exp(-jw) table for complex fft core
+    for (i=0; i<new_table->nfft/2; i++)
+    {
+        new_table->twiddle_factor[i].re = +cos(2. * M_PI * i / new_table->nfft);
+        new_table->twiddle_factor[i].im = -sin(2. * M_PI * i / new_table->nfft);
+    }
+
     // compute cos table for real fft
-    for (i=0; i<table.nfft/2; i++)
+    for (i=0; i<new_table->nfft/2; i++)
     {
-        table.cos_half[i] = cos(M_PI * i / table.nfft);
+        new_table->cos_half[i] = cos(M_PI * i / new_table->nfft);
     }
+
+    // the replaced table is kept, a transform may still read it (at most as large as the new one in total)
+    table.store(new_table, std::memory_order_release);
 }
 
 //------------------------------------------------------------------------------
 
 int table_get_nfft()
 {
-    return table.nfft;
+    return table.load(std::memory_order_acquire)->nfft;
 }
 
 //------------------------------------------------------------------------------
 
 complex_float64 *table_get_twiddle_factor()
 {
-    return table.twiddle_factor;
+    return table.load(std::memory_order_acquire)->twiddle_factor;
 }
 
 //------------------------------------------------------------------------------
 
 double *table_get_cos_half()
 {
-    return table.cos_half;
+    return table.load(std::memory_order_acquire)->cos_half;
 }
 
 //------------------------------------------------------------------------------
@@ -216,6 +232,7 @@ void fft_core(complex_float32 *x, complex_float64 *w, int nstride, int nfft)
 
 void rfft(float *input, complex_float32 *spectrum, int n)
 {
+    const fft_table *tab;
     int i, j, k, nfft, nstride;
     float tr, ti, rs, is, rd, id, rp, ip, ci, cj;
     complex_float32 *x;
@@ -234,33 +251,33 @@ void rfft(float *input, complex_float32 *spectrum, int n)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
+    if (table.load(std::memory_order_acquire)->nfft == 0)
         set_twiddle_table(n);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
         set_twiddle_table(n);
-        nstride = 1;
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -280,8 +297,8 @@ void rfft(float *input, complex_float32 *spectrum, int n)
     }
 
     x = spectrum;
-    w = table.twiddle_factor;
-    cos2table = table.cos_half;
+    w = tab->twiddle_factor;
+    cos2table = tab->cos_half;
 
     fft_core(x, w, nstride, nfft);
 
@@ -325,6 +342,7 @@ void rfft(float *input, complex_float32 *spectrum, int n)
 
 void irfft(complex_float32 *spectrum, float *output, int n)
 {
+    const fft_table *tab;
     int i, j, k, nfft, nstride;
     float t0, tn, rs, is, rd, id, rp, ip, ci, cj, norm;
     complex_float32 *x;
@@ -343,33 +361,33 @@ void irfft(complex_float32 *spectrum, float *output, int n)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
+    if (table.load(std::memory_order_acquire)->nfft == 0)
         set_twiddle_table(n);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
         set_twiddle_table(n);
-        nstride = 1;
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -379,8 +397,8 @@ void irfft(complex_float32 *spectrum, float *output, int n)
     }
 
     x = (complex_float32 *) output;
-    w = table.twiddle_factor;
-    cos2table = table.cos_half;
+    w = tab->twiddle_factor;
+    cos2table = tab->cos_half;
 
     //----- Half Length Preprocessing ------------------------------------------
 
@@ -430,6 +448,7 @@ void irfft(complex_float32 *spectrum, float *output, int n)
 
 void cfft(complex_float32 *x, int nfft)
 {
+    const fft_table *tab;
     int i, k, nstride;
 
     if (nfft == 0 || x == NULL)
@@ -442,33 +461,33 @@ void cfft(complex_float32 *x, int nfft)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
-        set_twiddle_table(nfft);
+    if (table.load(std::memory_order_acquire)->nfft == 0)
+        set_twiddle_table(2*nfft);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
-        set_twiddle_table(nfft);
-        nstride = 1;
+        set_twiddle_table(2*nfft);
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -477,13 +496,14 @@ void cfft(complex_float32 *x, int nfft)
         return;
     }
 
-    fft_core(x, table.twiddle_factor, nstride, nfft);
+    fft_core(x, tab->twiddle_factor, nstride, nfft);
 }
 
 //------------------------------------------------------------------------------
 
 void icfft(complex_float32 *x, int nfft)
 {
+    const fft_table *tab;
     int i, k, nstride;
 
     if (nfft == 0 || x == NULL)
@@ -496,33 +516,33 @@ void icfft(complex_float32 *x, int nfft)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
-        set_twiddle_table(nfft);
+    if (table.load(std::memory_order_acquire)->nfft == 0)
+        set_twiddle_table(2*nfft);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
-        set_twiddle_table(nfft);
-        nstride = 1;
+        set_twiddle_table(2*nfft);
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -534,7 +554,7 @@ void icfft(complex_float32 *x, int nfft)
     for (i=0; i<nfft; i++)
         x[i].im = -x[i].im;
 
-    fft_core(x, table.twiddle_factor, nstride, nfft);
+    fft_core(x, tab->twiddle_factor, nstride, nfft);
 
     for (i=0; i<nfft; i++)
         x[i].im = -x[i].im;
@@ -719,6 +739,7 @@ void fft_core_double(complex_float64 *x, complex_float64 *w, int nstride, int nf
 
 void rfft_double(double *input, complex_float64 *spectrum, int n)
 {
+    const fft_table *tab;
     int i, j, k, nfft, nstride;
     double tr, ti, rs, is, rd, id, rp, ip, ci, cj;
     complex_float64 *x, *w;
@@ -736,33 +757,33 @@ void rfft_double(double *input, complex_float64 *spectrum, int n)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
+    if (table.load(std::memory_order_acquire)->nfft == 0)
         set_twiddle_table(n);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
         set_twiddle_table(n);
-        nstride = 1;
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -782,8 +803,8 @@ void rfft_double(double *input, complex_float64 *spectrum, int n)
     }
 
     x = spectrum;
-    w = table.twiddle_factor;
-    cos2table = table.cos_half;
+    w = tab->twiddle_factor;
+    cos2table = tab->cos_half;
 
     fft_core_double(x, w, nstride, nfft);
 
@@ -827,6 +848,7 @@ void rfft_double(double *input, complex_float64 *spectrum, int n)
 
 void irfft_double(complex_float64 *spectrum, double *output, int n)
 {
+    const fft_table *tab;
     int i, j, k, nfft, nstride;
     double t0, tn, rs, is, rd, id, rp, ip, ci, cj, norm;
     complex_float64 *x, *w;
@@ -844,33 +866,33 @@ void irfft_double(complex_float64 *spectrum, double *output, int n)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
+    if (table.load(std::memory_order_acquire)->nfft == 0)
         set_twiddle_table(n);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
         set_twiddle_table(n);
-        nstride = 1;
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -880,8 +902,8 @@ void irfft_double(complex_float64 *spectrum, double *output, int n)
     }
 
     x = (complex_float64 *) output;
-    w = table.twiddle_factor;
-    cos2table = table.cos_half;
+    w = tab->twiddle_factor;
+    cos2table = tab->cos_half;
 
     //----- Half Length Preprocessing ------------------------------------------
 
@@ -931,6 +953,7 @@ void irfft_double(complex_float64 *spectrum, double *output, int n)
 
 void cfft_double(complex_float64 *x, int nfft)
 {
+    const fft_table *tab;
     int i, k, nstride;
 
     if (nfft == 0 || x == NULL)
@@ -943,33 +966,33 @@ void cfft_double(complex_float64 *x, int nfft)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
-        set_twiddle_table(nfft);
+    if (table.load(std::memory_order_acquire)->nfft == 0)
+        set_twiddle_table(2*nfft);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
-        set_twiddle_table(nfft);
-        nstride = 1;
+        set_twiddle_table(2*nfft);
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -978,13 +1001,14 @@ void cfft_double(complex_float64 *x, int nfft)
         return;
     }
 
-    fft_core_double(x, table.twiddle_factor, nstride, nfft);
+    fft_core_double(x, tab->twiddle_factor, nstride, nfft);
 }
 
 //------------------------------------------------------------------------------
 
 void icfft_double(complex_float64 *x, int nfft)
 {
+    const fft_table *tab;
     int i, k, nstride;
 
     if (nfft == 0 || x == NULL)
@@ -997,33 +1021,33 @@ void icfft_double(complex_float64 *x, int nfft)
     }
 
     // create new table if missing
-    if (table.nfft == 0)
-        set_twiddle_table(nfft);
+    if (table.load(std::memory_order_acquire)->nfft == 0)
+        set_twiddle_table(2*nfft);
 
-    // table stride
-    k = table.nfft;
+    // table stride, the table is read through one snapshot
+    tab = table.load(std::memory_order_acquire);
+    k = tab->nfft;
 
     if (k < nfft)
     {
         // create new table if too small
-        set_twiddle_table(nfft);
-        nstride = 1;
+        set_twiddle_table(2*nfft);
+        tab = table.load(std::memory_order_acquire);
+        k = tab->nfft;
     }
-    else
+
+    // compute table stride
+    nstride = -1;
+    i = 0;
+    while (k)
     {
-        // compute table stride
-        nstride = -1;
-        i = 0;
-        while (k)
+        if (k == nfft)
         {
-            if (k == nfft)
-            {
-                nstride = i;
-                break;
-            }
-            k = k >> 1;
-            i++;
+            nstride = i;
+            break;
         }
+        k = k >> 1;
+        i++;
     }
 
     if (nstride < 0)
@@ -1035,7 +1059,7 @@ void icfft_double(complex_float64 *x, int nfft)
     for (i=0; i<nfft; i++)
         x[i].im = -x[i].im;
 
-    fft_core_double(x, table.twiddle_factor, nstride, nfft);
+    fft_core_double(x, tab->twiddle_factor, nstride, nfft);
 
     for (i=0; i<nfft; i++)
         x[i].im = -x[i].im;
@@ -0,0 +1,75 @@
+/*-----------------------------------------------------------------------------*\
+| Generator of precomputed filter spectra files. Reads a raw float64 IR bank    |
+| (layout of interleavedIR, e.g. concatenated Kemar_TUBerlin_*.bin files),      |
+| transforms it IR by IR for the given block length and writes the file that is |
+| loaded by TVOLAP(spectraFile, blockLen, numChansAudio). Usage:                |
+| makeSpectraFile irBank.bin numIR lenIR numChansIR blockLen spectra.tvs        |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdexcept>
+#include <iostream>
+#include "TVOLAP.h"
+
+int main(int argc, char **argv)
+{
+    if (argc != 7)
+    {
+        std::cerr << "usage: makeSpectraFile irBank.bin numIR lenIR numChansIR blockLen spectra.tvs" << std::endl;
+        return -1;
+    }
+
+    const uint32_t numIR = uint32_t(atol(argv[2]));
+    const uint32_t lenIR = uint32_t(atol(argv[3]));
+    const uint32_t numChansIR = uint32_t(atol(argv[4]));
+    const uint32_t blockLen = uint32_t(atol(argv[5]));
+
+    if (numIR == 0 || lenIR == 0 || numChansIR == 0 || blockLen == 0)
+    {
+        std::cerr << "numIR, lenIR, numChansIR and blockLen must be positive" << std::endl;
+        return -1;
+    }
+
+    // a cache of one IR is enough, the spectra are written IR by IR
+    const uint32_t numParts = (lenIR-1)/(2*blockLen)+1;
+    const uint64_t bytesPerIR = uint64_t(numChansIR)*numParts*(2*blockLen+1)*sizeof(complex_float64);
+
+    try
+    {
+        TVOLAP TVOLAPInst(argv[1], numIR, lenIR, numChansIR, blockLen, 1, bytesPerIR);
+
+        if (TVOLAPInst.saveFilterSpectra(argv[6]) < 0)
+        {
+            std::cerr << "cannot write " << argv[6] << std::endl;
+            return -1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -0,0 +1,147 @@
+/*-----------------------------------------------------------------------------*\
+| Precision and speed check of the reduced filter banks. Renders the same noise |
+| input through a float64 bank of decaying noise IRs and through its float32,   |
+| bfloat16 and int16 copies (see FilterBank.h), with an IR switch every 50      |
+| blocks, and prints the spectral SNR of each bank, the SNR of its output       |
+| against the float64 output, the size of the spectra and the processing time   |
+| per block, the fastest of 20 short runs that take turns. Returns -1 if the    |
+| median time of a reduced bank relative to the float64 run of the same turn is |
+| above one. Optional arguments: IR length, block length, number of channels.   |
+|                                                                               |
+| Author: (c) TVOLAP contributors                               October 2026    |
+| LGPL Release: October 2026, License see end of file                           |
+\*-----------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include <iomanip>
+#include "TVOLAP.h"
+#include "FilterBank.h"
+
+int main(int argc, char **argv)
+{
+    const uint32_t lenIR = argc > 1 ? atoi(argv[1]) : 65536;
+    const uint32_t blockLen = argc > 2 ? atoi(argv[2]) : 512;
+    const uint32_t numChans = argc > 3 ? atoi(argv[3]) : 8;
+    const uint32_t numIR = 4;
+    const uint32_t numBlocks = 400;
+    const uint32_t numTimedBlocks = 50;
+    const uint32_t numTimings = 20;
+    const char *precisionNames[] = {"float64", "float32", "bfloat16", "int16"};
+
+    std::vector<double> interleavedIR(uint64_t(numIR)*numChans*lenIR);
+    std::vector<double> testSignal(uint64_t(numBlocks)*blockLen*numChans);
+    std::vector<double> refSignal, outSignal;
+    srand(1);
+
+    //test IRs are noise decaying by 60 dB over their length, the input is white noise
+    for (uint64_t i=0; i<interleavedIR.size(); i++)
+        interleavedIR[i] = (double(rand())/RAND_MAX-0.5)*exp(-6.9*double(i%lenIR)/lenIR);
+
+    for (uint64_t i=0; i<testSignal.size(); i++)
+        testSignal[i] = double(rand())/RAND_MAX-0.5;
+
+    std::shared_ptr<const FilterBank> banks[FilterBank::PRECISION_INT16+1];
+    std::unique_ptr<TVOLAP> insts[FilterBank::PRECISION_INT16+1];
+    double outSnrDB[FilterBank::PRECISION_INT16+1], usPerBlock[FilterBank::PRECISION_INT16+1];
+    std::vector<double> runUs[FilterBank::PRECISION_INT16+1], ratios;
+    int result = 0;
+
+    banks[FilterBank::PRECISION_FLOAT64].reset(new FilterBank(interleavedIR.data(), numIR, lenIR, numChans, blockLen));
+    for (uint32_t p=FilterBank::PRECISION_FLOAT64; p<=FilterBank::PRECISION_INT16; p++)
+    {
+        if (p != FilterBank::PRECISION_FLOAT64)
+            banks[p].reset(new FilterBank(*banks[FilterBank::PRECISION_FLOAT64], FilterBank::Precision(p)));
+        insts[p].reset(new TVOLAP(banks[p], numChans));
+        usPerBlock[p] = INFINITY;
+    }
+
+    std::cout << "lenIR " << lenIR << ", blockLen " << blockLen << ", " << numChans << " channels" << std::endl;
+
+    for (uint32_t p=FilterBank::PRECISION_FLOAT64; p<=FilterBank::PRECISION_INT16; p++)
+    {
+        outSignal = testSignal;
+        for (uint32_t i=0; i<numBlocks; i++)
+        {
+            if (i%50 == 0)
+                insts[p]->setIR((i/50)%numIR);
+
+            insts[p]->process(&outSignal[uint64_t(i)*numChans*blockLen]);
+        }
+
+        if (p == FilterBank::PRECISION_FLOAT64)
+            refSignal = outSignal;
+
+        double errEnergy = 0.0, sigEnergy = 0.0;
+        for (uint64_t i=0; i<outSignal.size(); i++)
+        {
+            errEnergy += (outSignal[i]-refSignal[i])*(outSignal[i]-refSignal[i]);
+            sigEnergy += refSignal[i]*refSignal[i];
+        }
+        outSnrDB[p] = errEnergy > 0.0 ? 10*log10(sigEnergy/errEnergy) : INFINITY;
+    }
+
+    //short runs of the precisions take turns, so a slow phase of the machine hits the runs of one turn alike
+    for (uint32_t t=0; t<numTimings; t++)
+    {
+        for (uint32_t p=FilterBank::PRECISION_FLOAT64; p<=FilterBank::PRECISION_INT16; p++)
+        {
+            outSignal = testSignal;
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (uint32_t i=0; i<numTimedBlocks; i++)
+                insts[p]->process(&outSignal[uint64_t(i)*numChans*blockLen]);
+            runUs[p].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-start).count()/numTimedBlocks);
+            usPerBlock[p] = std::min(usPerBlock[p], runUs[p].back());
+        }
+    }
+
+    for (uint32_t p=FilterBank::PRECISION_FLOAT64; p<=FilterBank::PRECISION_INT16; p++)
+    {
+        std::cout << std::left << std::setw(9) << precisionNames[p] << std::right << std::fixed << std::setprecision(1)
+                  << " spectral SNR " << std::setw(6) << banks[p]->getSnrDB() << " dB"
+                  << "  output SNR " << std::setw(6) << outSnrDB[p] << " dB"
+                  << "  spectra " << std::setw(7) << banks[p]->getNumBytes()/1048576.0 << " MB"
+                  << "  " << std::setw(7) << usPerBlock[p] << " us/block" << std::endl;
+    }
+
+    //smaller spectra that are not faster than float64 are no gain, every run is compared with the float64 run of its turn
+    for (uint32_t p=FilterBank::PRECISION_FLOAT32; p<=FilterBank::PRECISION_INT16; p++)
+    {
+        ratios.clear();
+        for (uint32_t t=0; t<numTimings; t++)
+            ratios.push_back(runUs[p][t]/runUs[FilterBank::PRECISION_FLOAT64][t]);
+        std::sort(ratios.begin(), ratios.end());
+
+        if (ratios[numTimings/2] > 1.0)
+        {
+            std::cout << precisionNames[p] << " is slower than float64, median time ratio " << std::setprecision(3) << ratios[numTimings/2] << std::endl;
+            result = -1;
+        }
+    }
+
+    return result;
+}
+
+/*------------------------------License---------------------------------------*\
+| Copyright (c) 2026 TVOLAP contributors                                       |
+|                                                                              |
+| This program is free software: you can redistribute it and/or modify         |
+| it under the terms of the GNU Lesser General Public License as published by  |
+| the Free Software Foundation, either version 3 of the License, or            |
+| (at your option) any later version.                                          |
+|                                                                              |
+| This program is distributed in the hope that it will be useful,              |
+| but WITHOUT ANY WARRANTY; without even the implied warranty of               |
+| MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                |
+| GNU Lesser General Public License for more details.                          |
+|                                                                              |
+| You should have received a copy of the GNU Lesser General Public License     |
+| along with this program. If not, see <http://www.gnu.org/licenses/>.         |
+\*----------------------------------------------------------------------------*/
@@ -10,17 +10,97 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 #include <vector>
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include "TVOLAP.h"
+#include "IRBankManager.h"
+#include "MinPhaseBank.h"
 
 #ifndef M_PI
 #define M_PI    3.14159265358979323846
 #endif
 
+struct IRSource
+{
+    const double *interleavedIR;
+    uint32_t numChans, lenIR;
+};
+
+//reads the IRs for an instance with IR cache
+static int readIR(void *context, uint32_t irIdx, uint32_t chanIdx, uint32_t sampleBeg, uint32_t numSamples, double *dest)
+{
+    const IRSource *source = (const IRSource *) context;
+    const double *samples = source->interleavedIR+(uint64_t(irIdx)*source->numChans+chanIdx)*source->lenIR+sampleBeg;
+
+    std::copy(samples, samples+numSamples, dest);
+    return 0;
+}
+
+//switches to the next IR every 50 blocks, like the example below
+static void renderBlocks(TVOLAP &inst, std::vector<double> &signal, uint32_t numChans, uint32_t blockLen, uint32_t numBlocks)
+{
+    for (uint32_t i=0, k=0; i<numBlocks; i++)
+    {
+        if (i%50 == 49)
+            inst.setIR(++k);
+
+        inst.process(&signal[i*numChans*blockLen]);
+    }
+}
+
+//renders like renderBlocks() through the planar overloads of process(), out of place or in place
+template <typename T>
+static void renderPlanar(TVOLAP &inst, const std::vector<double> &signal, std::vector<double> &result, uint32_t numChans,
+        uint32_t blockLen, uint32_t numBlocks, bool inPlace)
+{
+    std::vector< std::vector<T> > inBuf(numChans, std::vector<T>(blockLen)), outBuf(inBuf);
+    std::vector<const T *> inPtr(numChans);
+    std::vector<T *> outPtr(numChans);
+
+    for (uint32_t j=0; j<numChans; j++)
+    {
+        inPtr[j] = inBuf[j].data();
+        outPtr[j] = inPlace ? inBuf[j].data() : outBuf[j].data();
+    }
+
+    result.resize(signal.size());
+    for (uint32_t i=0, k=0; i<numBlocks; i++)
+    {
+        if (i%50 == 49)
+            inst.setIR(++k);
+
+        for (uint32_t l=0; l<blockLen; l++)
+        {
+            for (uint32_t j=0; j<numChans; j++)
+                inBuf[j][l] = T(signal[(i*blockLen+l)*numChans+j]);
+        }
+        inst.process(inPtr.data(), outPtr.data());
+        for (uint32_t l=0; l<blockLen; l++)
+        {
+            for (uint32_t j=0; j<numChans; j++)
+                result[(i*blockLen+l)*numChans+j] = double(outPtr[j][l]);
+        }
+    }
+}
+
+//largest difference of out, delayed by delay samples per channel, to ref
+static double maxDiff(const std::vector<double> &ref, const std::vector<double> &out, uint32_t numChans, uint32_t delay)
+{
+    double diff = 0.0;
+
+    for (uint32_t i=0; i+delay*numChans<out.size(); i++)
+        diff = std::max(diff, fabs(out[i+delay*numChans]-ref[i]));
+
+    return diff;
+}
+
 int main()
 {
     //----------------------------TestSignalGeneration----------------------------------
@@ -116,6 +196,393 @@ int main()
     	}
     }
 
+    //-------------------------Equivalence to serial process()---------------------------
+
+    const uint32_t numCheckBlocks = 200;
+    const double maxCheckDiff = 1e-12;
+    const uint32_t numParts = (numSampsIRPerChan-1)/(2*blockLen)+1;
+    const uint64_t bytesPerIR = uint64_t(numChans)*numParts*(2*blockLen+1)*sizeof(complex_float64);
+    IRSource irSource = {interleavedIR.data(), numChans, numSampsIRPerChan};
+    TVOLAP::CacheStats cacheStats;
+    std::vector<double> checkInput(testSignalInterleaved.begin(), testSignalInterleaved.begin()+numCheckBlocks*numChans*blockLen);
+    std::vector<double> checkRef(checkInput), checkOut, silence(numChans*blockLen);
+    std::vector<double> stagedBank(interleavedIR), stagedIR(interleavedIR.begin()+19*numChans*numSampsIRPerChan, interleavedIR.end());
+    double diff;
+    int checkResult = 0;
+
+    {
+        TVOLAP serialInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        renderBlocks(serialInst, checkRef, numChans, blockLen, numCheckBlocks);
+    }
+
+    //pipeline: the output is delayed by getLatency() samples
+    {
+        TVOLAP pipelineInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        pipelineInst.setParallelMode(TVOLAP::PARALLEL_PIPELINE, 3);
+        checkOut = checkInput;
+        renderBlocks(pipelineInst, checkOut, numChans, blockLen, numCheckBlocks);
+        diff = maxDiff(checkRef, checkOut, numChans, pipelineInst.getLatency());
+        std::cout << "pipeline: max. difference " << diff << std::endl;
+        checkResult |= diff > maxCheckDiff;
+    }
+
+    //planar float and double buffers, out of place and in place, against interleaved process() in the
+    //same parallel mode, float I/O only adds the rounding of input and output
+    {
+        const TVOLAP::ParallelMode planarModes[3] = {TVOLAP::PARALLEL_OFF, TVOLAP::PARALLEL_CHANNELS, TVOLAP::PARALLEL_PIPELINE};
+        const char *planarNames[3] = {"serial", "channels", "pipeline"};
+        const double maxFloatDiff = 1e-6;
+        std::vector<double> planarOut;
+        double planarDiff[4];
+
+        for (uint32_t modeCnt=0; modeCnt<3; modeCnt++)
+        {
+            TVOLAP interleavedInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+            interleavedInst.setParallelMode(planarModes[modeCnt], 3);
+            checkOut = checkInput;
+            renderBlocks(interleavedInst, checkOut, numChans, blockLen, numCheckBlocks);
+
+            for (uint32_t planarCnt=0; planarCnt<4; planarCnt++)
+            {
+                TVOLAP planarInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+                planarInst.setParallelMode(planarModes[modeCnt], 3);
+                if (planarCnt < 2)
+                    renderPlanar<double>(planarInst, checkInput, planarOut, numChans, blockLen, numCheckBlocks, planarCnt == 1);
+                else
+                    renderPlanar<float>(planarInst, checkInput, planarOut, numChans, blockLen, numCheckBlocks, planarCnt == 3);
+                planarDiff[planarCnt] = maxDiff(checkOut, planarOut, numChans, 0);
+            }
+
+            std::cout << "planar " << planarNames[modeCnt] << ": max. difference double " << planarDiff[0] << " / " << planarDiff[1]
+                      << " (in place), float " << planarDiff[2] << " / " << planarDiff[3] << " (in place)" << std::endl;
+            checkResult |= planarDiff[0] > maxCheckDiff || planarDiff[1] > maxCheckDiff;
+            checkResult |= planarDiff[2] > maxFloatDiff || planarDiff[3] > maxFloatDiff;
+        }
+    }
+
+    //setIR(chan, ir) for the channels 0..3 and setIR(first, num, ir) for the group 4..7, every channel against an
+    //instance that switches all channels to the IR of that channel
+    {
+        TVOLAP chanInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        std::vector<double> groupRef;
+        double chanDiff = 0.0;
+
+        checkOut = checkInput;
+        for (uint32_t i=0; i<numCheckBlocks; i++)
+        {
+            if (i%50 == 0)
+            {
+                for (uint32_t j=0; j<4; j++)
+                    chanInst.setIR(j, (i/50+3*j)%numIR);
+                chanInst.setIR(4, numChans-4, (i/50+12)%numIR);
+            }
+
+            chanInst.process(&checkOut[i*numChans*blockLen]);
+        }
+
+        for (uint32_t g=0; g<5; g++)
+        {
+            TVOLAP groupInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+            groupRef = checkInput;
+            for (uint32_t i=0; i<numCheckBlocks; i++)
+            {
+                if (i%50 == 0)
+                    groupInst.setIR((i/50+3*g)%numIR);
+
+                groupInst.process(&groupRef[i*numChans*blockLen]);
+            }
+
+            for (uint32_t j=g; j<(g < 4 ? g+1 : numChans); j++)
+            {
+                for (uint32_t l=0; l<numCheckBlocks*blockLen; l++)
+                    chanDiff = std::max(chanDiff, fabs(checkOut[l*numChans+j]-groupRef[l*numChans+j]));
+            }
+        }
+        std::cout << "per channel IRs: max. difference " << chanDiff << std::endl;
+        checkResult |= chanDiff > maxCheckDiff;
+    }
+
+    //IR events at offsets inside blocks: every channel follows the output of its previous IR up to the time stamp
+    //and crossfades to the output of the new IR over the fadeLen (IR_EVENT_FADE_LEN) samples from there on
+    {
+        const uint32_t fadeLen = 128, numEvents = 4;
+        const uint64_t eventIdx[numEvents] = {20*blockLen+37, 50*blockLen, 80*blockLen+511, 110*blockLen+450};
+        const uint32_t eventChan[numEvents] = {0, 0, 4, 0}, eventNum[numEvents] = {numChans, 4, 4, numChans};
+        const uint32_t eventIR[numEvents] = {5, 11, 11, 0};
+        TVOLAP eventInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        std::vector< std::vector<double> > irOut(numIR);
+        TVOLAP::EventStats eventStats;
+        double eventDiff = 0.0, expected, fadeGain;
+        uint32_t srcIR, dstIR, eventCnt = 0;
+        int64_t fadeBeg, inIdx;
+
+        for (uint32_t e=0; e<numEvents; e++)
+        {
+            if (!irOut[eventIR[e]].empty())
+                continue;
+
+            TVOLAP irInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+            irInst.setIR(eventIR[e]);
+            irOut[eventIR[e]] = checkInput;
+            for (uint32_t i=0; i<numCheckBlocks; i++)
+                irInst.process(&irOut[eventIR[e]][i*numChans*blockLen]);
+        }
+
+        checkResult |= eventInst.queueIR(0, 0, numChans, numIR) == 0;
+        checkOut = checkInput;
+        for (uint32_t i=0; i<numCheckBlocks; i++)
+        {
+            //the events of a block are queued before it is processed
+            for (; eventCnt<numEvents && eventIdx[eventCnt]<uint64_t(i+1)*blockLen; eventCnt++)
+                eventInst.queueIR(eventIdx[eventCnt], eventChan[eventCnt], eventNum[eventCnt], eventIR[eventCnt]);
+
+            eventInst.process(&checkOut[i*numChans*blockLen]);
+        }
+        eventInst.getEventStats(eventStats);
+
+        //the output sample l belongs to the input sample l-blockLen
+        for (uint32_t j=0; j<numChans; j++)
+        {
+            for (uint32_t l=0; l<numCheckBlocks*blockLen; l++)
+            {
+                inIdx = int64_t(l)-int64_t(blockLen);
+                srcIR = dstIR = 0;
+                fadeBeg = -int64_t(fadeLen);
+                for (uint32_t e=0; e<numEvents; e++)
+                {
+                    if (j >= eventChan[e] && j < eventChan[e]+eventNum[e] && int64_t(eventIdx[e]) <= inIdx)
+                    {
+                        srcIR = dstIR;
+                        dstIR = eventIR[e];
+                        fadeBeg = int64_t(eventIdx[e]);
+                    }
+                }
+
+                expected = irOut[dstIR][l*numChans+j];
+                if (inIdx < fadeBeg+int64_t(fadeLen))
+                {
+                    fadeGain = 0.5-0.5*cos(M_PI*(double(inIdx-fadeBeg)+0.5)/fadeLen);
+                    expected = irOut[srcIR][l*numChans+j]+fadeGain*(expected-irOut[srcIR][l*numChans+j]);
+                }
+                eventDiff = std::max(eventDiff, fabs(checkOut[l*numChans+j]-expected));
+            }
+        }
+
+        std::cout << "IR events: max. difference " << eventDiff << " (" << eventStats.numEvents << " events, " << eventStats.numRejected
+                  << " rejected, latency " << eventStats.minLatency << " ... " << eventStats.maxLatency << ")" << std::endl;
+        checkResult |= eventDiff > maxCheckDiff || eventStats.numEvents != numEvents || eventStats.numRejected != 1;
+        checkResult |= eventStats.minLatency != fadeLen/2 || eventStats.maxLatency != fadeLen/2 || eventStats.jitter != 0.0;
+    }
+
+    //damped oscillators (minimum phase) behind delays of 128...352 samples: MinPhaseBank must find every delay,
+    //keep only the significant length, and the instance on it must render like the original bank
+    {
+        const uint32_t numMinPhaseIR = 5, lenMinPhaseIR = 768;
+        std::vector<double> minPhaseIR(numMinPhaseIR*numChans*lenMinPhaseIR, 0.0), minPhaseRef(checkInput);
+        uint32_t delay, numWrongDelays = 0;
+        double errEnergy = 0.0, refEnergy = 0.0, outErrorDB;
+
+        for (uint32_t i=0; i<numMinPhaseIR; i++)
+        {
+            for (uint32_t j=0; j<numChans; j++)
+            {
+                delay = 128+32*((i+j)%8);
+                for (uint32_t l=0; l+delay<lenMinPhaseIR; l++)
+                    minPhaseIR[(i*numChans+j)*lenMinPhaseIR+delay+l] = pow(0.94+0.005*j, double(l))*cos((0.2+0.3*i)*l);
+            }
+        }
+
+        MinPhaseBank minPhaseBank(minPhaseIR.data(), numMinPhaseIR, lenMinPhaseIR, numChans);
+        for (uint32_t i=0; i<numMinPhaseIR; i++)
+        {
+            for (uint32_t j=0; j<numChans; j++)
+                numWrongDelays += minPhaseBank.getDelay(i, j) != 128+32*((i+j)%8);
+        }
+
+        TVOLAP origInst(minPhaseIR, numMinPhaseIR, lenMinPhaseIR, numChans, blockLen, numChans);
+        TVOLAP minPhaseInst(minPhaseBank, blockLen, numChans);
+        renderBlocks(origInst, minPhaseRef, numChans, blockLen, numCheckBlocks);
+        checkOut = checkInput;
+        renderBlocks(minPhaseInst, checkOut, numChans, blockLen, numCheckBlocks);
+        for (uint32_t l=0; l<checkOut.size(); l++)
+        {
+            errEnergy += (checkOut[l]-minPhaseRef[l])*(checkOut[l]-minPhaseRef[l]);
+            refEnergy += minPhaseRef[l]*minPhaseRef[l];
+        }
+        outErrorDB = 10.0*log10(errEnergy/refEnergy);
+
+        std::cout << "minimum phase bank: " << numWrongDelays << " wrong delays, " << minPhaseBank.getLenIR() << " of " << lenMinPhaseIR
+                  << " samples kept, error " << minPhaseBank.getErrorDB() << " dB, output error " << outErrorDB << " dB" << std::endl;
+        checkResult |= numWrongDelays != 0 || minPhaseBank.getLenIR()+minPhaseBank.getMaxDelay() > lenMinPhaseIR;
+        checkResult |= minPhaseBank.getErrorDB() > -60.0 || outErrorDB > minPhaseBank.getErrorDB()+3.0;
+    }
+
+    //processOffline() with the IR schedule of renderBlocks(), from the filter bank and with the smallest IR cache
+    {
+        TVOLAP offlineInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        TVOLAP cacheInst(readIR, &irSource, numIR, numSampsIRPerChan, numChans, blockLen, numChans,
+                TVOLAP::MISS_TRANSFORM, numChans*bytesPerIR);
+        std::vector<uint32_t> irSchedule(numCheckBlocks);
+        double offlineDiff, cacheDiff;
+        int offlineResult, cacheResult;
+
+        for (uint32_t i=0; i<numCheckBlocks; i++)
+            irSchedule[i] = (i+1)/50;
+
+        checkOut.assign(checkInput.size(), 0.0);
+        offlineResult = offlineInst.processOffline(checkInput.data(), checkOut.data(), numCheckBlocks*blockLen, irSchedule, 3);
+        offlineDiff = maxDiff(checkRef, checkOut, numChans, 0);
+        checkOut.assign(checkInput.size(), 0.0);
+        cacheResult = cacheInst.processOffline(checkInput.data(), checkOut.data(), numCheckBlocks*blockLen, irSchedule, 3);
+        cacheDiff = maxDiff(checkRef, checkOut, numChans, 0);
+        std::cout << "offline: max. difference " << offlineDiff << ", with IR cache " << cacheDiff << std::endl;
+        checkResult |= offlineResult < 0 || cacheResult < 0 || offlineDiff > maxCheckDiff || cacheDiff > maxCheckDiff;
+    }
+
+    //smallest IR cache (one IR per channel), the prefetch thread transforms the next IRs while process() runs
+    {
+        TVOLAP prefetchInst(readIR, &irSource, numIR, numSampsIRPerChan, numChans, blockLen, numChans,
+                TVOLAP::MISS_TRANSFORM, numChans*bytesPerIR);
+        prefetchInst.setPrefetch(2);
+        checkOut = checkInput;
+        renderBlocks(prefetchInst, checkOut, numChans, blockLen, numCheckBlocks);
+        prefetchInst.getCacheStats(cacheStats);
+        diff = maxDiff(checkRef, checkOut, numChans, 0);
+        std::cout << "prefetch: max. difference " << diff << " (" << cacheStats.numPrefetches << " prefetched, "
+                  << cacheStats.numMisses << " missed)" << std::endl;
+        checkResult |= diff > maxCheckDiff;
+    }
+
+    //deferred misses: every IR is requested on silence until the prefetch thread delivered it, the
+    //state stays silent, so the following signal must render like on a fresh instance
+    {
+        TVOLAP deferInst(readIR, &irSource, numIR, numSampsIRPerChan, numChans, blockLen, numChans,
+                TVOLAP::MISS_DEFER);
+        for (uint32_t k=1, waitCnt=0; k<=numCheckBlocks/50 && waitCnt<10000; waitCnt++)
+        {
+            deferInst.setIR(k);
+            deferInst.process(silence.data());
+            deferInst.getCacheStats(cacheStats);
+            if (cacheStats.numPrefetches == k)
+                k++;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        deferInst.setIR(0u);
+        checkOut = checkInput;
+        renderBlocks(deferInst, checkOut, numChans, blockLen, numCheckBlocks);
+        diff = maxDiff(checkRef, checkOut, numChans, 0);
+        std::cout << "deferred misses: max. difference " << diff << " (" << cacheStats.numPrefetches << " deferred)" << std::endl;
+        checkResult |= diff > maxCheckDiff || cacheStats.numPrefetches != numCheckBlocks/50;
+    }
+
+    //IR 3 replaced by IR 19 with stageIR() / publishIR() while IR 0 plays, compared to an instance
+    //constructed with the replaced IR
+    {
+        std::copy(stagedIR.begin(), stagedIR.end(), stagedBank.begin()+3*numChans*numSampsIRPerChan);
+        TVOLAP bankInst(stagedBank, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        TVOLAP stageInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        std::vector<double> stagedRef(checkInput);
+
+        renderBlocks(bankInst, stagedRef, numChans, blockLen, numCheckBlocks);
+        checkOut = checkInput;
+        for (uint32_t i=0; i<10; i++)
+            stageInst.process(&checkOut[i*numChans*blockLen]);
+        stageInst.stageIR(3, stagedIR);
+        stageInst.publishIR();
+        for (uint32_t i=10, k=0; i<numCheckBlocks; i++)
+        {
+            if (i%50 == 49)
+                stageInst.setIR(++k);
+
+            stageInst.process(&checkOut[i*numChans*blockLen]);
+        }
+        diff = maxDiff(stagedRef, checkOut, numChans, 0);
+        std::cout << "stage/publish: max. difference " << diff << std::endl;
+        checkResult |= diff > maxCheckDiff;
+    }
+
+#if defined(__linux__)
+    //the bank file is rewritten with IR 0 and 3 replaced by IR 19 and 18 while IR 0 plays, the manager
+    //swaps both in one block, from then on the output equals an instance constructed on the new file
+    {
+        const char *bankFile = "tstBank.bin";
+        const uint32_t irSize = numChans*numSampsIRPerChan;
+        std::vector<double> watchRef(checkInput);
+        std::ofstream bankOut(bankFile, std::ios::out | std::ios::binary);
+        IRBankManager manager;
+        IRBankManager::BankStats bankStats = {0, 0, 0, 0};
+        uint32_t swapBlock = numCheckBlocks;
+        int bankId;
+
+        bankOut.write((const char *) interleavedIR.data(), std::streamsize(interleavedIR.size()*sizeof(double)));
+        bankOut.close();
+        bankId = manager.addBank(bankFile, numIR, numSampsIRPerChan, numChans);
+
+        TVOLAP watchInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);
+        checkOut = checkInput;
+        if (bankId < 0 || manager.attach(uint32_t(bankId), &watchInst) < 0 || manager.start() < 0)
+            checkResult |= 1;
+
+        for (uint32_t i=0; i<numCheckBlocks; i++)
+        {
+            if (i == 10)
+            {
+                stagedBank = interleavedIR;
+                std::copy(interleavedIR.begin()+19*irSize, interleavedIR.begin()+20*irSize, stagedBank.begin());
+                std::copy(interleavedIR.begin()+18*irSize, interleavedIR.begin()+19*irSize, stagedBank.begin()+3*irSize);
+                bankOut.open(bankFile, std::ios::out | std::ios::binary);
+                bankOut.write((const char *) stagedBank.data(), std::streamsize(stagedBank.size()*sizeof(double)));
+                bankOut.close();
+            }
+            if (i == 150)
+                watchInst.setIR(3);
+
+            watchInst.process(&checkOut[i*numChans*blockLen]);
+
+            //the next block swaps the published batch in
+            if (i >= 10 && swapBlock == numCheckBlocks)
+            {
+                manager.getStats(uint32_t(bankId), bankStats);
+                if (bankStats.numReloads > 0 && bankStats.numPending == 0)
+                    swapBlock = i+1;
+                else
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        manager.detach(uint32_t(bankId), &watchInst);
+        manager.stop();
+
+        TVOLAP fileInst(bankFile, numIR, numSampsIRPerChan, numChans, blockLen, numChans, 2*numChans*bytesPerIR);
+        for (uint32_t i=0; i<numCheckBlocks; i++)
+        {
+            if (i == 150)
+                fileInst.setIR(3);
+
+            fileInst.process(&watchRef[i*numChans*blockLen]);
+        }
+        remove(bankFile);
+
+        //the windowed switch is complete two blocks after the swap
+        diff = 1.0;
+        if (swapBlock+2 < 150)
+        {
+            std::vector<double> swappedRef(watchRef.begin()+(swapBlock+2)*numChans*blockLen, watchRef.end());
+            std::vector<double> swappedOut(checkOut.begin()+(swapBlock+2)*numChans*blockLen, checkOut.end());
+            diff = maxDiff(swappedRef, swappedOut, numChans, 0);
+        }
+        std::cout << "bank file rewrite: max. difference " << diff << " (" << bankStats.numChangedIRs << " IRs changed, swapped in block "
+                  << swapBlock << ")" << std::endl;
+        checkResult |= diff > maxCheckDiff || bankStats.numChangedIRs != 2;
+    }
+#endif
+
+    if (checkResult)
+    {
+        std::cout << "equivalence check failed" << std::endl;
+        return -1;
+    }
+
     //---------------------------------TVOLAP init----------------------------------------
 
     TVOLAP TVOLAPInst(interleavedIR, numIR, numSampsIRPerChan, numChans, blockLen, numChans);